@@ -0,0 +1,217 @@
+#include "../evaporation/evaporation.h"
+#include "../evaporation/replica_batch.h"
+#include "../evaporation/result_file.h"
+#include "../evaporation/statistics.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+constexpr static size_t   batchWidth      = 8;        // replicas advanced together, one per SIMD lane
+constexpr static unsigned numOfIter       = 5000;     // iterations of one replica
+constexpr static unsigned averagingSteps  = 500;      // last iterations which temperature is averaged over
+constexpr static double   maxSegment      = 0.05;     // longest allowed piece of normalized loss(T) curve
+constexpr static double   lossErrorTarget = 0.02;     // allowed error bar of loss of a point, part of particles
+constexpr static unsigned extraReplicas   = 8;        // replicas added to a noisy point at once
+constexpr static unsigned maxReplicas     = 64;       // replicas of one point at most
+constexpr static unsigned maxRefinements  = 6;        // intervals are halved at most that many times
+
+// one period of the grid with results of all its replicas
+struct Point
+{
+    double            m_period;          // period in equilibrium distances
+    unsigned          m_depth;           // number of halvings of the initial interval
+    RunningStatistics m_temperature;     // temperature of replicas
+    RunningStatistics m_loss;            // lost particles of replicas
+};
+
+// one replica to run
+struct Job
+{
+    size_t m_point;                      // index of point
+};
+
+// runs jobs in batches and adds results to points, also writes every replica as in analysis.cpp,
+// every batch takes the next seed
+static void run_jobs(std::vector<Point>& points, const std::vector<Job>& jobs, ReplicaBatch<batchWidth>& batch,
+                     unsigned width, unsigned height, double eqDis, uint64_t& seed, ResultWriter& f)
+{
+    for (size_t first = 0; first < jobs.size(); first += batchWidth)
+    {
+        ReplicaBatch<batchWidth>::LaneValues periods;
+
+        // spare lanes repeat the last job, their results are dropped
+        for (size_t l = 0; l < batchWidth; ++l)
+            periods[l] = points[jobs[std::min(first + l, jobs.size() - 1)].m_point].m_period * eqDis;
+
+        batch.SetSeed(seed);
+        batch.SetInitialConditions(width, height, periods);
+        batch.Process(numOfIter - averagingSteps);
+        batch.ResetStatistics();
+        batch.Process(averagingSteps);
+
+        auto loss = batch.GetParticlesLoss();
+
+        for (size_t l = 0; (l < batchWidth) && (first + l < jobs.size()); ++l)
+        {
+            auto& temperature = batch.GetTemperatureStatistics(l);
+            auto& point       = points[jobs[first + l].m_point];
+
+            point.m_temperature.Add(temperature.GetMean());
+            point.m_loss.Add(loss[l]);
+
+            f.Add({ point.m_period, seed, batch.GetIteration(), temperature.GetMean(), temperature.GetError(), loss[l],
+                    temperature.IsConverged() });
+        }
+
+        ++seed;
+    }
+}
+
+int main()
+{
+    Model m;
+    ReplicaBatch<batchWidth> batch;
+    batch.EvaluateTimeStep(0.01);
+
+    double   left  = 0.9, right  = 1.5;
+    unsigned width = 6,   height = 6;
+
+    unsigned numOfInitialPoints = 9;
+    unsigned initialReplicas    = 8;
+    unsigned budget             = 1000;
+    double   initTemp           = 0;
+
+    std::cout << "Type configuration (width height,f.e 4 4):"  << std::endl;
+    std::cin >> width >> height;
+
+    std::cout << "Type num of initial points:" << std::endl;
+    std::cin >> numOfInitialPoints;
+
+    std::cout << "Type num of replicas per new point:" << std::endl;
+    std::cin >> initialReplicas;
+
+    std::cout << "Type max num of replicas:" << std::endl;
+    std::cin >> budget;
+
+    std::cout << "Type initial velocities (Kelvin):" << std::endl;
+    std::cin >> initTemp;
+
+    batch.SetTemperature(initTemp);
+
+    numOfInitialPoints = std::max(2u, numOfInitialPoints);
+    initialReplicas    = std::max(2u, initialReplicas);
+
+    std::stringstream ss;
+    ss << "out" << width << 'x' << height << "_adaptive.bin";
+
+    ResultWriter f(ss.str(), width, height);
+
+    uint64_t seed = std::random_device{}();
+
+    std::cout << "Seed: " << seed << std::endl;
+
+    double eqDis        = m.GetEquilibriumDistance();
+    double numParticles = (double)height * (double)width;
+
+    std::vector<Point> points;
+
+    for (unsigned i = 0; i < numOfInitialPoints; ++i)
+        points.push_back({ left + (right - left) * i / (numOfInitialPoints - 1), 0, {}, {} });
+
+    std::vector<Job> jobs;
+
+    for (size_t p = 0; p < points.size(); ++p)
+        for (unsigned r = 0; r < initialReplicas; ++r)
+            jobs.push_back({ p });
+
+    unsigned done = 0;
+
+    for (unsigned round = 0; !jobs.empty() && (done < budget); ++round)
+    {
+        jobs.resize(std::min<size_t>(jobs.size(), budget - done));
+
+        run_jobs(points, jobs, batch, width, height, eqDis, seed, f);
+        done += jobs.size();
+        jobs.clear();
+
+        // curve loss(T) is measured in parts of its ranges, so both axes weigh the same
+        double tMin = INFINITY, tMax = - INFINITY;
+
+        for (auto& p : points)
+        {
+            if (p.m_temperature.GetCount() == 0)
+                continue;
+
+            tMin = std::min(tMin, p.m_temperature.GetMean());
+            tMax = std::max(tMax, p.m_temperature.GetMean());
+        }
+
+        double tRange = std::max(tMax - tMin, 1E-9);
+
+        // intervals where the curve changes fast are halved
+        std::vector<Point> refined;
+
+        for (size_t p = 0; p < points.size(); ++p)
+        {
+            refined.push_back(points[p]);
+
+            if (p + 1 == points.size())
+                break;
+
+            const Point& a = points[p];
+            const Point& b = points[p + 1];
+
+            if ((a.m_loss.GetCount() == 0) || (b.m_loss.GetCount() == 0))
+                continue;
+
+            double dT    = (b.m_temperature.GetMean() - a.m_temperature.GetMean()) / tRange;
+            double dLoss = (b.m_loss.GetMean() - a.m_loss.GetMean()) / numParticles;
+            unsigned depth = std::max(a.m_depth, b.m_depth) + 1;
+
+            if ((std::hypot(dT, dLoss) > maxSegment) && (depth <= maxRefinements))
+                refined.push_back({ (a.m_period + b.m_period) / 2, depth, {}, {} });
+        }
+
+        points.swap(refined);
+
+        // new points get their first replicas, noisy points get more, flat ones are left as they are
+        for (size_t p = 0; p < points.size(); ++p)
+        {
+            auto& point = points[p];
+
+            unsigned replicas = 0;
+
+            if (point.m_loss.GetCount() == 0)
+                replicas = initialReplicas;
+            else if ((point.m_loss.GetStandardError() / numParticles > lossErrorTarget) &&
+                     (point.m_loss.GetCount() < maxReplicas))
+                replicas = extraReplicas;
+
+            for (unsigned r = 0; r < replicas; ++r)
+                jobs.push_back({ p });
+        }
+
+        std::cout << "Round: " << round << ". Points: " << points.size() << ". Replicas: " << done << std::endl;
+    }
+
+    // points which did not get replicas because of the budget are dropped
+    std::stringstream ssSummary;
+    ssSummary << "out" << width << 'x' << height << "_points.txt";
+
+    std::ofstream summary(ssSummary.str());
+
+    for (auto& p : points)
+    {
+        if (p.m_loss.GetCount() == 0)
+            continue;
+
+        summary << p.m_period << ' ' << p.m_temperature.GetMean() << ' ' << p.m_temperature.GetStandardError() << ' '
+                << p.m_loss.GetMean() << ' ' << p.m_loss.GetStandardError() << ' ' << p.m_loss.GetCount() << std::endl;
+    }
+
+    std::cout << "Replicas: " << done << " of budget " << budget << std::endl;
+}
@@ -1,16 +1,26 @@
+#include "../evaporation/curve_fit.h"
 #include "../evaporation/evaporation.h"
+#include "../evaporation/replica_batch.h"
+#include "../evaporation/result_file.h"
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <random>
 #include <sstream>
 #include <vector>
 
-constexpr static double boltzman_constant = 1.38E-23;
+constexpr static size_t   batchWidth        = 8;    // replicas advanced together, one per SIMD lane
+constexpr static unsigned checkInterval     = 100;  // iterations between checks of error bars
+constexpr static double   binsMax           = 90;   // right edge of temperature bins, xrange of plots (Kelvin)
+constexpr static size_t   numOfBins         = 90;   // temperature bins of summary
+constexpr static double   fitTemperatureMax = 37;   // TEMPERATURE_MAX of plots, 75 / 2 is integer there (Kelvin)
 
 int main()
 {
 
     Model m;
-    m.EvaluateTimeStep(0.01);
+    ReplicaBatch<batchWidth> batch;
+    batch.EvaluateTimeStep(0.01);
 
     double   left  = 0.9, right  = 1.5;
     unsigned width = 6,   height = 6;
@@ -18,15 +28,21 @@ int main()
     unsigned numOfExperimentsPerStep = 10;
     unsigned numOfSteps              = 100;
     double   initTemp         = 0;
+    double   targetError      = 0;
 
     std::cout << "Type configuration (width height,f.e 4 4):"  << std::endl;
     std::cin >> width >> height;
 
 
     std::stringstream ss;
-    ss << "out" << width << 'x' << height << ".txt";
+    ss << "out" << width << 'x' << height << ".bin";
 
-    std::ofstream f(ss.str());
+    // text layout of older runs is made by result_to_text
+    ResultWriter f(ss.str(), width, height);
+
+    // summary is gathered as replicas finish, so plots need not read every replica
+    BinnedCurve bins(0, binsMax, numOfBins);
+    LinearFit   fit;
 
     std::cout << "Type num of steps:" << std::endl;
     std::cin >> numOfSteps;
@@ -37,18 +53,29 @@ int main()
     std::cout << "Type initial velocities (Kelvin):" << std::endl;
     std::cin >> initTemp;
 
-    m.SetTemperature(initTemp);
+    // old configurations end here, averaging is fixed for them
+    std::cout << "Type target error of temperature (Kelvin, 0 - fixed averaging):" << std::endl;
+    if (!(std::cin >> targetError))
+        targetError = 0;
+
+    batch.SetTemperature(initTemp);
 
     std::cout << "Period interval: " << left << ' ' << right << std::endl;
     std::cout << "Particles amount: " << width << 'x' << height << std::endl;
     std::cout << "Number of experiments: " << numOfExperimentsPerStep << std::endl;
     std::cout << "Number of points: " << numOfSteps << std::endl;
     std::cout << "Initial velocities: " << initTemp << std::endl;
+    std::cout << "Target error: " << targetError << std::endl;
+
+    uint64_t baseSeed = std::random_device{}();
+
+    std::cout << "Seed: " << baseSeed << std::endl;
 
     double   b                 = 0;
     unsigned numOfIter         = 5000;
     unsigned averagingSteps      = 500;
     unsigned numOfIterDuration = numOfIter - averagingSteps;
+    unsigned maxAveragingSteps = 20 * averagingSteps;
 
     // std::vector<double> temprature(numOfSteps);
     // std::vector<int> loss(numOfSteps);
@@ -56,37 +83,114 @@ int main()
     // double t_sum    = 0;
     // double loss_sum = 0;
 
-    double period = 0;
     double eqDis  = m.GetEquilibriumDistance();
 
-    double numParticles = (double)height * (double)width;
+    // Every (point, experiment) pair is one replica, replicas are packed into
+    // batches in output order so that all lanes of a batch are busy
+    unsigned numOfJobs = numOfSteps * numOfExperimentsPerStep;
+    unsigned doneSteps = 0;
 
-    for (auto i = 0; i < numOfSteps; ++i)
+    for (unsigned first = 0; first < numOfJobs; first += batchWidth)
     {
-        b      = left + (right - left) * i / (double)numOfSteps;
-        period = b * eqDis;
+        ReplicaBatch<batchWidth>::LaneValues periods;
+        ReplicaBatch<batchWidth>::LaneValues points;
 
-        for (auto j = 0; j < numOfExperimentsPerStep; ++j)
+        for (size_t l = 0; l < batchWidth; ++l)
         {
-            m.SetInitialConditions(width, height, period);
-
-            m.Process(numOfIterDuration);
-            m.GetKineticEnergySum();
-            m.Process(averagingSteps);
-            
-            double temperature = m.GetKineticEnergySum() / numParticles / boltzman_constant / averagingSteps;
-            double loss = m.GetParticlesLoss();
-            f << temperature << ' ' << loss << std::endl;
+            unsigned job = std::min<unsigned>(first + l, numOfJobs - 1);
+
+            b          = left + (right - left) * (job / numOfExperimentsPerStep) / (double)numOfSteps;
+            points[l]  = b;
+            periods[l] = b * eqDis;
         }
 
+        // every batch gets its own seed, so a batch can be repeated from the result file
+        uint64_t seed = baseSeed + first / batchWidth;
 
-        // t_sum    = 0;
-        // loss_sum = 0;
+        batch.SetSeed(seed);
+        batch.SetInitialConditions(width, height, periods);
+
+        batch.Process(numOfIterDuration);
+        batch.ResetStatistics();
+
+        batch.Process(averagingSteps);
+
+        // averaging goes on until error bars of all replicas converge and meet the target, never less than
+        // averagingSteps; the fixed averaging of old configurations is usually too short to converge
+        for (unsigned steps = averagingSteps; (targetError > 0) && (steps < maxAveragingSteps); steps += checkInterval)
+        {
+            bool done = true;
+
+            for (size_t l = 0; l < batchWidth; ++l)
+            {
+                auto& temperature = batch.GetTemperatureStatistics(l);
+
+                done = done && temperature.IsConverged() && (temperature.GetError() <= targetError);
+            }
+
+            if (done)
+                break;
+
+            batch.Process(checkInterval);
+        }
+
+        auto loss = batch.GetParticlesLoss();
+
+        for (size_t l = 0; (l < batchWidth) && (first + l < numOfJobs); ++l)
+        {
+            auto& temperature = batch.GetTemperatureStatistics(l);
+            f.Add({ points[l], seed, batch.GetIteration(), temperature.GetMean(), temperature.GetError(), loss[l],
+                    temperature.IsConverged() });
 
-        std::cout << "Point: " << i << '/' << numOfSteps << std::endl;
+            bins.Add(temperature.GetMean(), loss[l]);
+
+            if (temperature.GetMean() < fitTemperatureMax)
+                fit.Add(temperature.GetMean(), loss[l]);
+        }
+
+        for (; (doneSteps + 1) * numOfExperimentsPerStep <= std::min<unsigned>(first + batchWidth, numOfJobs); ++doneSteps)
+            std::cout << "Point: " << doneSteps << '/' << numOfSteps << std::endl;
     }
 
     // Write in file
     // for (auto i = 0; i < numOfSteps; ++i)
         // f << temprature.at(i) << ' ' << loss.at(i) << std::endl;
+
+    // bins: center, mean temperature, mean loss, error of loss, number of replicas
+    std::stringstream ssBins;
+    ssBins << "out" << width << 'x' << height << "_bins.txt";
+
+    std::ofstream fBins(ssBins.str());
+
+    for (size_t i = 0; i < bins.GetBins().size(); ++i)
+    {
+        auto& bin = bins.GetBins()[i];
+
+        if (bin.m_y.GetCount() == 0)
+            continue;
+
+        double error = (bin.m_y.GetCount() > 1) ? bin.m_y.GetStandardError() : 0;
+
+        fBins << bins.GetCenter(i) << ' ' << bin.m_x.GetMean() << ' ' << bin.m_y.GetMean() << ' ' << error << ' '
+              << bin.m_y.GetCount() << '\n';
+    }
+
+    // fit of f(x) = a * x + b as gnuplot variables, plots load it instead of fitting
+    std::stringstream ssFit;
+    ssFit << "out" << width << 'x' << height << "_fit.gp";
+
+    std::ofstream fFit(ssFit.str());
+
+    auto coefficients = fit.GetCoefficients();
+    auto errors       = fit.GetErrors();
+
+    fFit.precision(10);
+    fFit << "a = " << coefficients[1] << '\n';
+    fFit << "b = " << coefficients[0] << '\n';
+    fFit << "a_err = " << errors[1] << '\n';
+    fFit << "b_err = " << errors[0] << '\n';
+    fFit << "fit_points = " << fit.GetCount() << '\n';
+
+    std::cout << "Fit: a = " << coefficients[1] << " +/- " << errors[1]
+              << ", b = " << coefficients[0] << " +/- " << errors[0] << std::endl;
 }
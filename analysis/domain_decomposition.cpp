@@ -0,0 +1,112 @@
+#include "../evaporation/domain_decomposition.h"
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+constexpr static double checkTolerance = 0.01;  // difference of final energies of N ranks and 1 rank relative to the initial one
+
+// results of one run, valid on rank 0
+struct Run
+{
+    size_t   amount      = 0;
+    double   e0          = 0;
+    double   e1          = 0;
+    double   temperature = 0;
+    uint32_t loss        = 0;
+    double   speed       = 0;
+    int      ranks       = 1;
+};
+
+// periodic cube filled by the grid, slabs along x are split between ranks of comm
+static Run run(MPI_Comm comm, int nodes, unsigned steps, unsigned threads)
+{
+    DomainSystem<3> s(comm);
+
+    double a = s.GetEquilibriumDistance();
+
+    s.SetModelingSpace(nodes * a, nodes * a, nodes * a);
+    s.SetBoundaries(Boundary::Periodic);
+    s.SetThreads(threads);
+    s.SetTemperature(60);
+    s.SetSeed(1);
+    s.EvaluateTimeStep(0.01);
+    s.SetInitialConditions(nodes, nodes, nodes, a);
+
+    Run r;
+
+    r.amount = s.GetParticlesAmount();
+    r.ranks  = s.GetRanksAmount();
+
+    s.GetKineticEnergySum();
+    s.GetPotentialEnergySum();
+    s.Process(1);
+
+    r.e0 = s.GetKineticEnergySum() + s.GetPotentialEnergySum();
+
+    s.Process(steps);
+
+    s.GetKineticEnergySum();
+    s.GetPotentialEnergySum();
+    s.Process(1);
+
+    r.e1          = s.GetKineticEnergySum() + s.GetPotentialEnergySum();
+    r.temperature = s.GetTemperature();
+    r.loss        = s.GetParticlesLoss();
+    r.speed       = s.GetNsPerAtomStep();
+
+    return r;
+}
+
+static void print(const Run& r)
+{
+    std::cout << "Ranks: " << r.ranks << std::endl;
+    std::cout << "Particles amount: " << r.amount << std::endl;
+    std::cout << "Energy per particle (eV): " << r.e0 / r.amount / 1.602176634E-19 << " -> " << r.e1 / r.amount / 1.602176634E-19 << std::endl;
+    std::cout << "Temperature: " << r.temperature << " K" << std::endl;
+    std::cout << "Particles out of the area: " << r.loss << std::endl;
+    std::cout << "Speed: " << r.speed << " ns/atom-step" << std::endl;
+}
+
+// usage: mpirun -np <ranks> domain_decomposition [nodes per axis] [steps] [threads per rank]
+// with several ranks the run is repeated on rank 0 alone, the exit code is 1 if they disagree
+int main(int argc, char* argv[])
+{
+    MPI_Init(&argc, &argv);
+
+    int      nodes   = (argc > 1) ? std::atoi(argv[1]) : 40;
+    unsigned steps   = (argc > 2) ? unsigned(std::atoi(argv[2])) : 100;
+    unsigned threads = (argc > 3) ? unsigned(std::atoi(argv[3])) : 1;
+
+    int rank = 0;
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    Run split = run(MPI_COMM_WORLD, nodes, steps, threads);
+    int failed = 0;
+
+    if (rank == 0)
+    {
+        print(split);
+
+        if (split.ranks > 1)
+        {
+            // trajectories of different splits diverge and temperatures fluctuate, the total energy is kept
+            Run single = run(MPI_COMM_SELF, nodes, steps, threads);
+
+            double difference = std::abs(split.e1 - single.e1) / std::abs(single.e0);
+
+            failed = !(difference <= checkTolerance) || (split.amount != single.amount) || (split.loss != single.loss);
+
+            std::cout << "Energy per particle on 1 rank (eV): " << single.e1 / single.amount / 1.602176634E-19 << std::endl;
+            std::cout << "Temperature on 1 rank: " << single.temperature << " K" << std::endl;
+            std::cout << "Particles out of the area on 1 rank: " << single.loss << std::endl;
+            std::cout << "Check against 1 rank: " << (failed ? "failed" : "passed") << std::endl;
+        }
+    }
+
+    MPI_Bcast(&failed, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+    MPI_Finalize();
+
+    return failed;
+}
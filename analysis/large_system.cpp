@@ -0,0 +1,64 @@
+#include "../evaporation/large_system.h"
+#include <iostream>
+
+int main()
+{
+    LargeSystem<2> s;
+
+    unsigned width   = 1000, height = 1000;
+    unsigned steps   = 100;
+    unsigned threads = 0;
+    unsigned numa    = 0;
+    double   initTemp = 20;
+
+    std::cout << "Type configuration (width height,f.e 1000 1000):" << std::endl;
+    std::cin >> width >> height;
+
+    std::cout << "Type num of steps:" << std::endl;
+    std::cin >> steps;
+
+    std::cout << "Type num of threads (0 - all cores):" << std::endl;
+    std::cin >> threads;
+
+    std::cout << "Type NUMA placement (0 - off, 1 - on):" << std::endl;
+    std::cin >> numa;
+
+    std::cout << "Type initial velocities (Kelvin):" << std::endl;
+    std::cin >> initTemp;
+
+    double a = s.GetEquilibriumDistance();
+
+    // area with free space around the grid, particles which leave it are lost
+    s.SetModelingSpace(2. * height * a, 2. * width * a);
+    s.SetThreads(threads);
+    s.SetNumaPlacement(numa != 0);
+    s.SetTemperature(initTemp);
+    s.EvaluateTimeStep(0.01);
+    s.SetInitialConditions(width, height, a);
+
+    std::cout << "Particles amount: " << s.GetParticlesAmount() << std::endl;
+    std::cout << "Threads: " << s.GetThreadsAmount() << ", NUMA nodes: " << s.GetNodesAmount() << std::endl;
+
+    s.GetKineticEnergySum();
+    s.GetPotentialEnergySum();
+    s.Process(1);
+
+    double e0 = s.GetKineticEnergySum() + s.GetPotentialEnergySum();
+
+    s.Process(steps);
+
+    s.GetKineticEnergySum();
+    s.GetPotentialEnergySum();
+    s.Process(1);
+
+    double e1 = s.GetKineticEnergySum() + s.GetPotentialEnergySum();
+
+    std::cout << "Energy drift per particle (eV): " << (e1 - e0) / s.GetParticlesAmount() / 1.602176634E-19 << std::endl;
+    std::cout << "Temperature: " << s.GetTemperature() << " K" << std::endl;
+    std::cout << "Lost particles: " << s.GetParticlesLoss() << std::endl;
+    std::cout << "Memory: " << s.GetBytesPerAtom() << " bytes/atom" << std::endl;
+    std::cout << "Speed: " << s.GetNsPerAtomStep() << " ns/atom-step" << std::endl;
+    std::cout << "Remote pages: " << s.GetRemoteAccessRatio() << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,52 @@
+#include "../evaporation/result_file.h"
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+// converts binary results of analyse to the text layout "T loss Terr converged" read by plt,
+// with "-a" all columns are written: period seed stop_iteration T loss Terr converged;
+// converged is 0 when Terr is only a lower bound, averaging was too short for blocking to converge
+int main(int argc, char* argv[])
+{
+    bool all = (argc > 1) && (std::string(argv[1]) == "-a");
+
+    if (argc < 2 + all)
+    {
+        std::cerr << "Usage: result_to_text [-a] in.bin [out.txt]" << std::endl;
+        return 1;
+    }
+
+    ResultReader reader(argv[1 + all]);
+
+    if (!reader.IsValid())
+    {
+        std::cerr << "Not a result file: " << argv[1 + all] << std::endl;
+        return 1;
+    }
+
+    FILE* out = (argc > 2 + all) ? fopen(argv[2 + all], "w") : stdout;
+
+    if (out == nullptr)
+    {
+        std::cerr << "Can not create: " << argv[2 + all] << std::endl;
+        return 1;
+    }
+
+    // %g keeps the 6 significant digits of the former ofstream output
+    ResultRecord r;
+    size_t       count = 0;
+
+    while (reader.Next(r))
+    {
+        if (all)
+            fprintf(out, "%.10g %llu %u ", r.m_period, (unsigned long long)r.m_seed, r.m_stopIteration);
+
+        fprintf(out, "%g %u %g %d\n", r.m_temperature, r.m_loss, r.m_temperatureError, int(r.m_converged));
+        ++count;
+    }
+
+    if (out != stdout)
+        fclose(out);
+
+    std::cerr << reader.GetWidth() << 'x' << reader.GetHeight() << ": " << count << " replicas" << std::endl;
+}
@@ -13,4 +13,9 @@ cd result
 ../build/analyse < 5x5_cfg.txt
 ../build/analyse < 6x6_cfg.txt
 
+# raw results are binary, text files are made for gnuplot
+../build/result_to_text out4x4.bin out4x4.txt
+../build/result_to_text out5x5.bin out5x5.txt
+../build/result_to_text out6x6.bin out6x6.txt
+
 gnuplot plt
@@ -0,0 +1,97 @@
+#include "../evaporation/evaporation.h"
+#include "../evaporation/trajectory_codec.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+int main()
+{
+    Model m;
+
+    unsigned width     = 30, height = 30;
+    unsigned frames    = 200;
+    unsigned every     = 1;
+    double   precision = 1E-3;
+    unsigned threads   = 0;
+    double   initTemp  = 20;
+
+    std::cout << "Type configuration (width height,f.e 30 30):" << std::endl;
+    std::cin >> width >> height;
+
+    std::cout << "Type num of frames and steps between frames:" << std::endl;
+    std::cin >> frames >> every;
+
+    std::cout << "Type precision (equilibrium distances, f.e 0.001):" << std::endl;
+    std::cin >> precision;
+
+    std::cout << "Type num of threads (0 - all cores):" << std::endl;
+    std::cin >> threads;
+
+    std::cout << "Type initial velocities (Kelvin):" << std::endl;
+    std::cin >> initTemp;
+
+    double a = m.GetEquilibriumDistance();
+
+    m.SetTemperature(initTemp);
+    m.EvaluateTimeStep(0.01);
+    m.SetInitialConditions(width, height, 1.1 * a);
+
+    std::stringstream ss;
+    ss << "trajectory" << width << 'x' << height << ".trj";
+
+    // frames are kept to measure the error after reading the file back
+    std::vector<std::array<std::vector<double>, 2>> original;
+
+    double   processTime = 0, recordTime = 0;
+    uint64_t bytes       = 0;
+
+    {
+        TrajectoryWriter<2> writer(ss.str(), precision, a, threads);
+
+        for (unsigned frame = 0; frame < frames; ++frame)
+        {
+            auto t0 = std::chrono::steady_clock::now();
+            m.Process(every);
+            auto t1 = std::chrono::steady_clock::now();
+            writer.Record(m);
+            auto t2 = std::chrono::steady_clock::now();
+
+            processTime += std::chrono::duration<double>(t1 - t0).count();
+            recordTime  += std::chrono::duration<double>(t2 - t1).count();
+
+            auto view = m.ObserveParticlePositions();
+            original.push_back({ std::vector<double>(view[0].begin(), view[0].end()),
+                                 std::vector<double>(view[1].begin(), view[1].end()) });
+        }
+
+        bytes = writer.GetBytes();
+    }
+
+    TrajectoryReader<2> reader(ss.str());
+
+    std::array<std::vector<double>, 2> r;
+    uint32_t iteration = 0;
+    unsigned decoded   = 0;
+    double   maxError  = 0;
+
+    while ((decoded < original.size()) && reader.Next(r, iteration))
+    {
+        for (size_t k = 0; k < 2; ++k)
+            for (size_t i = 0; i < r[k].size(); ++i)
+                maxError = std::max(maxError, fabs(r[k][i] - original[decoded][k][i]));
+
+        ++decoded;
+    }
+
+    double raw = double(frames) * m.GetParticlesAmount() * 2 * sizeof(double);
+
+    std::cout << "Frames: " << decoded << " of " << frames << std::endl;
+    std::cout << "Compression: " << raw / bytes << " (" << bytes << " of " << raw << " bytes)" << std::endl;
+    std::cout << "Max error: " << maxError / a << " equilibrium distances, bound " << precision / 2 << std::endl;
+    std::cout << "Recording time: " << 100 * recordTime / processTime << "% of processing" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include "../evaporation/evaporation.h"
+#include "../evaporation/trajectory_export.h"
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+int main()
+{
+    Model m;
+
+    unsigned width    = 30, height = 30;
+    unsigned steps    = 1000;
+    unsigned every    = 1;
+    unsigned format   = 0;
+    double   initTemp = 20;
+
+    std::cout << "Type configuration (width height,f.e 30 30):" << std::endl;
+    std::cin >> width >> height;
+
+    std::cout << "Type num of steps and steps between frames:" << std::endl;
+    std::cin >> steps >> every;
+
+    std::cout << "Type format (0 - XYZ, 1 - extended XYZ, 2 - DCD):" << std::endl;
+    std::cin >> format;
+
+    std::cout << "Type initial velocities (Kelvin):" << std::endl;
+    std::cin >> initTemp;
+
+    const char* extensions[] = { "xyz", "extxyz", "dcd" };
+
+    format = std::min(format, 2u);
+
+    double a = m.GetEquilibriumDistance();
+
+    m.SetTemperature(initTemp);
+    m.EvaluateTimeStep(0.01);
+    m.SetInitialConditions(width, height, 1.1 * a);
+
+    std::stringstream ss;
+    ss << "trajectory" << width << 'x' << height << '.' << extensions[format];
+
+    double processTime = 0, feedTime = 0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    {
+        TrajectoryExporter<2> exporter(ss.str(), TrajectoryFormat(format), every);
+
+        exporter.SetBox(m.GetModelingSpace());
+
+        for (unsigned step = 0; step < steps; ++step)
+        {
+            auto t0 = std::chrono::steady_clock::now();
+            m.Process(1);
+            auto t1 = std::chrono::steady_clock::now();
+            exporter.Feed(m);
+            auto t2 = std::chrono::steady_clock::now();
+
+            processTime += std::chrono::duration<double>(t1 - t0).count();
+            feedTime    += std::chrono::duration<double>(t2 - t1).count();
+        }
+
+        if (!exporter.IsOpen())
+            std::cout << "Writing failed: " << ss.str() << std::endl;
+
+        // destructor waits for queued frames
+    }
+
+    double totalTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "File: " << ss.str() << std::endl;
+    std::cout << "Export time: " << 100 * feedTime / processTime << "% of processing" << std::endl;
+    std::cout << "Total time: " << 100 * totalTime / processTime << "% of processing" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,40 @@
+#include "evaporation.h"
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+//*********************************************************************************************************
+// Throughput of the kernels of the core library on a square cluster
+//*********************************************************************************************************
+// Usage: evaporation_core_benchmark [side [iterations]]
+//*********************************************************************************************************
+int main(int argc, char* argv[])
+{
+    int      side       = 32;
+    uint32_t iterations = 200;
+
+    if (argc > 1)
+        std::istringstream(argv[1]) >> side;
+    if (argc > 2)
+        std::istringstream(argv[2]) >> iterations;
+
+    Model m;
+
+    m.SetInitialConditions(side, side, 1.0 * m.GetEquilibriumDistance());
+    m.EvaluateTimeStep(0.01);
+
+    auto begin = std::chrono::steady_clock::now();
+
+    m.Process(iterations);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    auto   c       = m.GetPerformanceCounters();
+
+    std::cout << "atoms: "           << side * side
+              << ", iterations: "    << c.m_iterations
+              << ", iterations/s: "  << c.m_iterations / seconds
+              << ", ns/atom-step: "  << double(c.m_processTime) / c.m_particleSteps
+              << ", pairs/step: "    << double(c.m_pairEvaluations) / c.m_iterations << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,15 @@
+# kernels of the engine for the GUI, the same library as the evaporation_core target of CMakeLists.txt
+TEMPLATE = lib
+TARGET   = evaporation_core
+
+CONFIG  += c++17 staticlib
+CONFIG  -= qt
+
+DEFINES     += EVAPORATION_CORE
+INCLUDEPATH += ../evaporation
+
+# kernels are optimized in every build of the GUI except debug
+!msvc:CONFIG(release, debug|release): QMAKE_CXXFLAGS_RELEASE += -O3
+
+SOURCES += \
+    evaporation_core.cpp \
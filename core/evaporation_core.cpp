@@ -0,0 +1,27 @@
+#include "evaporation.h"
+#include "large_system.h"
+#include "replica_batch.h"
+#include "trajectory_codec.h"
+
+//*********************************************************************************************************
+// Kernels of the core library, declared extern at the end of the headers
+//*********************************************************************************************************
+template void BasicModel<2>::Process(uint32_t);
+template void BasicModel<2>::Process();
+template void BasicModel<3>::Process(uint32_t);
+template void BasicModel<3>::Process();
+
+template void LargeSystem<2>::Process(uint32_t);
+template void LargeSystem<2>::Process();
+template void LargeSystem<3>::Process(uint32_t);
+template void LargeSystem<3>::Process();
+template double LargeSystem<2>::forces();
+template double LargeSystem<3>::forces();
+
+template void ReplicaBatch<8>::Process(uint32_t);
+template void ReplicaBatch<8>::Process();
+
+template class TrajectoryEncoder<2>;
+template class TrajectoryEncoder<3>;
+template class TrajectoryDecoder<2>;
+template class TrajectoryDecoder<3>;
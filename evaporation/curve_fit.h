@@ -0,0 +1,322 @@
+#ifndef CURVE_FIT_H
+#define CURVE_FIT_H
+
+#include "statistics.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+//*********************************************************************************************************
+// PolynomialFit - least squares fit of y = c[0] + c[1] * x + ... + c[Degree] * x^Degree to a stream of points
+//*********************************************************************************************************
+// Only sums of powers are kept, so points are not stored and the fit can be read at any moment.
+// Error bars are asymptotic standard errors scaled by the residual variance, as gnuplot reports them.
+// Degree 1 is the straight line f(x) = a * x + b of the plotting scripts.
+//*********************************************************************************************************
+template <size_t Degree>
+class PolynomialFit
+{
+public:     // types
+
+    using Coefficients = std::array<double, Degree + 1>;                             //!< Coefficients by power of x
+
+private:    // types
+
+    using Matrix = std::array<std::array<double, Degree + 1>, Degree + 1>;           //!< Normal matrix
+
+private:    // variables
+
+    std::array<double, 2 * Degree + 1> m_sumX  = {};                                 //!< Sums of powers of x
+    Coefficients                       m_sumXY = {};                                 //!< Sums of powers of x by y
+    double                             m_sumYY = 0;                                  //!< Sum of squared y
+    uint64_t                           m_count = 0;                                  //!< Number of points
+
+public:     // methods
+
+    //*****************************************************************************************************
+    // Add() - add point
+    //*****************************************************************************************************
+    //! @param [in] x abscissa
+    //! @param [in] y ordinate
+    //*****************************************************************************************************
+    void Add(double x, double y)
+    {
+        double power = 1;
+
+        for (size_t k = 0; k < m_sumX.size(); ++k)
+        {
+            m_sumX[k] += power;
+
+            if (k <= Degree)
+                m_sumXY[k] += power * y;
+
+            power *= x;
+        }
+
+        m_sumYY += y * y;
+        ++m_count;
+    };
+
+    //*****************************************************************************************************
+    // Reset() - forget all points
+    //*****************************************************************************************************
+    void Reset()
+    {
+        *this = PolynomialFit();
+    };
+
+    //*****************************************************************************************************
+    // GetCount() - get number of points
+    //*****************************************************************************************************
+    //! @return number of points
+    //*****************************************************************************************************
+    uint64_t GetCount() const
+    {
+        return m_count;
+    };
+
+    //*****************************************************************************************************
+    // GetCoefficients() - get fitted coefficients
+    //*****************************************************************************************************
+    //! @return coefficients by power of x, NaN while there are too few points
+    //*****************************************************************************************************
+    Coefficients GetCoefficients() const
+    {
+        Coefficients c;
+        Matrix       inverse;
+
+        if (!invert(inverse))
+        {
+            c.fill(std::numeric_limits<double>::quiet_NaN());
+            return c;
+        }
+
+        for (size_t i = 0; i <= Degree; ++i)
+        {
+            c[i] = 0;
+
+            for (size_t j = 0; j <= Degree; ++j)
+                c[i] += inverse[i][j] * m_sumXY[j];
+        }
+
+        return c;
+    };
+
+    //*****************************************************************************************************
+    // GetErrors() - get standard errors of coefficients
+    //*****************************************************************************************************
+    //! @return errors by power of x, NaN while there are no more points than coefficients
+    //*****************************************************************************************************
+    Coefficients GetErrors() const
+    {
+        Coefficients e;
+        Matrix       inverse;
+
+        if ((m_count <= Degree + 1) || !invert(inverse))
+        {
+            e.fill(std::numeric_limits<double>::quiet_NaN());
+            return e;
+        }
+
+        double variance = GetResidualSumOfSquares() / double(m_count - Degree - 1);
+
+        for (size_t i = 0; i <= Degree; ++i)
+            e[i] = sqrt(std::max(0.0, variance * inverse[i][i]));
+
+        return e;
+    };
+
+    //*****************************************************************************************************
+    // GetResidualSumOfSquares() - get sum of squared deviations of points from the fit
+    //*****************************************************************************************************
+    //! @return sum of squared residuals
+    //*****************************************************************************************************
+    double GetResidualSumOfSquares() const
+    {
+        Coefficients c = GetCoefficients();
+
+        // for the least squares solution the sum is y'y - c'X'y
+        double ssr = m_sumYY;
+
+        for (size_t k = 0; k <= Degree; ++k)
+            ssr -= c[k] * m_sumXY[k];
+
+        return std::max(0.0, ssr);
+    };
+
+    //*****************************************************************************************************
+    // Evaluate() - get value of the fit
+    //*****************************************************************************************************
+    //! @param [in] x abscissa
+    //! @return fitted ordinate
+    //*****************************************************************************************************
+    double Evaluate(double x) const
+    {
+        Coefficients c = GetCoefficients();
+        double       y = 0;
+
+        for (size_t k = Degree + 1; k-- > 0; )
+            y = y * x + c[k];
+
+        return y;
+    };
+
+private:    // methods
+
+    //*****************************************************************************************************
+    // invert() - invert normal matrix by Gauss-Jordan elimination with partial pivoting
+    //*****************************************************************************************************
+    //! @param [out] inverse inverted matrix
+    //! @return false if the matrix is singular
+    //*****************************************************************************************************
+    bool invert(Matrix& inverse) const
+    {
+        Matrix a;
+
+        for (size_t i = 0; i <= Degree; ++i)
+            for (size_t j = 0; j <= Degree; ++j)
+            {
+                a[i][j]       = m_sumX[i + j];
+                inverse[i][j] = (i == j) ? 1 : 0;
+            }
+
+        for (size_t col = 0; col <= Degree; ++col)
+        {
+            size_t pivot = col;
+
+            for (size_t row = col + 1; row <= Degree; ++row)
+                if (fabs(a[row][col]) > fabs(a[pivot][col]))
+                    pivot = row;
+
+            if (!(fabs(a[pivot][col]) > 1E-12 * fabs(a[0][0])))
+                return false;
+
+            std::swap(a[col], a[pivot]);
+            std::swap(inverse[col], inverse[pivot]);
+
+            double scale = 1 / a[col][col];
+
+            for (size_t j = 0; j <= Degree; ++j)
+            {
+                a[col][j]       *= scale;
+                inverse[col][j] *= scale;
+            }
+
+            for (size_t row = 0; row <= Degree; ++row)
+            {
+                if (row == col)
+                    continue;
+
+                double factor = a[row][col];
+
+                for (size_t j = 0; j <= Degree; ++j)
+                {
+                    a[row][j]       -= factor * a[col][j];
+                    inverse[row][j] -= factor * inverse[col][j];
+                }
+            }
+        }
+
+        return true;
+    };
+};
+
+using LinearFit = PolynomialFit<1>;
+
+//*********************************************************************************************************
+// BinnedCurve - statistics of points y(x) in equal bins of x, a compact form of a cloud of points
+//*********************************************************************************************************
+class BinnedCurve
+{
+public:     // types
+
+    //*****************************************************************************************************
+    // Bin - points of one bin
+    //*****************************************************************************************************
+    struct Bin
+    {
+        RunningStatistics m_x;                                                       //!< Abscissas of points
+        RunningStatistics m_y;                                                       //!< Ordinates of points
+    };
+
+private:    // variables
+
+    double           m_min   = 0;                                                    //!< Left edge of the first bin
+    double           m_width = 1;                                                    //!< Width of bin
+    std::vector<Bin> m_bins;                                                         //!< Bins from left to right
+    uint64_t         m_outside = 0;                                                  //!< Points out of all bins
+
+public:     // methods
+
+    //*****************************************************************************************************
+    // Constructor
+    //*****************************************************************************************************
+    //! @param [in] min left edge of the first bin
+    //! @param [in] max right edge of the last bin
+    //! @param [in] bins number of bins
+    //*****************************************************************************************************
+    BinnedCurve(double min, double max, size_t bins)
+        : m_min(min)
+        , m_width((max - min) / std::max<size_t>(bins, 1))
+        , m_bins(std::max<size_t>(bins, 1))
+    {
+    };
+
+    //*****************************************************************************************************
+    // Add() - add point
+    //*****************************************************************************************************
+    //! @param [in] x abscissa
+    //! @param [in] y ordinate
+    //*****************************************************************************************************
+    void Add(double x, double y)
+    {
+        double bin = floor((x - m_min) / m_width);
+
+        if (!(bin >= 0) || (bin >= double(m_bins.size())))
+        {
+            ++m_outside;
+            return;
+        }
+
+        m_bins[size_t(bin)].m_x.Add(x);
+        m_bins[size_t(bin)].m_y.Add(y);
+    };
+
+    //*****************************************************************************************************
+    // GetBins() - get bins
+    //*****************************************************************************************************
+    //! @return bins from left to right
+    //*****************************************************************************************************
+    const std::vector<Bin>& GetBins() const
+    {
+        return m_bins;
+    };
+
+    //*****************************************************************************************************
+    // GetCenter() - get center of bin
+    //*****************************************************************************************************
+    //! @param [in] bin index of bin
+    //! @return abscissa of the center
+    //*****************************************************************************************************
+    double GetCenter(size_t bin) const
+    {
+        return m_min + (bin + 0.5) * m_width;
+    };
+
+    //*****************************************************************************************************
+    // GetOutside() - get number of points which fell out of all bins
+    //*****************************************************************************************************
+    //! @return number of points
+    //*****************************************************************************************************
+    uint64_t GetOutside() const
+    {
+        return m_outside;
+    };
+};
+
+#endif    // CURVE_FIT_H
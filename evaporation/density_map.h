@@ -0,0 +1,181 @@
+#ifndef DENSITY_MAP_H
+#define DENSITY_MAP_H
+
+#include "span.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <vector>
+
+//*********************************************************************************************************
+// DensityMap - particles binned into an image of counts and mean values per cell
+//*********************************************************************************************************
+// Every thread of the pool bins its part of particles into its own image, then cells of images are
+// summed in parallel, so no atomics are needed. With weights, like kinetic energies of particles, the
+// image holds their mean per cell, which gives a temperature map. Particles out of the area are skipped.
+//*********************************************************************************************************
+class DensityMap
+{
+private:    // variables
+
+    size_t                           m_width;                                        //!< Number of cells along x
+    size_t                           m_height;                                       //!< Number of cells along y
+    std::array<double, 2>            m_min = {0, 0};                                 //!< Lower corner of the area
+    std::array<double, 2>            m_invCell = {1, 1};                             //!< Cells per unit of length along axes
+    std::vector<double>              m_counts;                                       //!< Particles in every cell, rows along x
+    std::vector<double>              m_sums;                                         //!< Sum of weights in every cell
+    std::vector<std::vector<double>> m_partCounts;                                   //!< Counts binned by every thread
+    std::vector<std::vector<double>> m_partSums;                                     //!< Sums binned by every thread
+    std::unique_ptr<ThreadPool>      m_pool;                                         //!< Threads binning particles
+
+public:     // methods
+
+    //*****************************************************************************************************
+    // Constructor
+    //*****************************************************************************************************
+    //! @param [in] width number of cells along x
+    //! @param [in] height number of cells along y
+    //! @param [in, optional] threads number of threads, 0 means hardware concurrency
+    //*****************************************************************************************************
+    DensityMap(size_t width, size_t height, size_t threads = 0)
+        : m_width(std::max<size_t>(width, 1))
+        , m_height(std::max<size_t>(height, 1))
+        , m_counts(m_width * m_height, 0)
+        , m_sums(m_width * m_height, 0)
+        , m_pool(new ThreadPool(threads))
+    {
+        m_partCounts.resize(m_pool->GetThreadsAmount());
+        m_partSums.resize(m_pool->GetThreadsAmount());
+    };
+
+    //*****************************************************************************************************
+    // SetArea() - set binned rectangle
+    //*****************************************************************************************************
+    //! @param [in] minX left edge
+    //! @param [in] minY bottom edge
+    //! @param [in] maxX right edge
+    //! @param [in] maxY top edge
+    //*****************************************************************************************************
+    void SetArea(double minX, double minY, double maxX, double maxY)
+    {
+        if ((maxX <= minX) || (maxY <= minY))
+            return;
+
+        m_min     = { minX, minY };
+        m_invCell = { m_width / (maxX - minX), m_height / (maxY - minY) };
+    };
+
+    //*****************************************************************************************************
+    // Compute() - bin particles
+    //*****************************************************************************************************
+    //! @param [in] r x and y coordinates of particles
+    //! @param [in, optional] weights value of every particle to average per cell, empty for counts only
+    //*****************************************************************************************************
+    void Compute(const std::array<Span<const double>, 2>& r, Span<const double> weights = {})
+    {
+        size_t n       = std::min(r[0].size(), r[1].size());
+        size_t threads = m_pool->GetThreadsAmount();
+        size_t cells   = m_width * m_height;
+        bool   weigh   = !weights.empty();
+
+        m_pool->Run(threads, [&](size_t task, size_t)
+        {
+            auto& counts = m_partCounts[task];
+            auto& sums   = m_partSums[task];
+
+            counts.assign(cells, 0);
+
+            if (weigh)
+                sums.assign(cells, 0);
+
+            size_t begin = n * task / threads;
+            size_t end   = n * (task + 1) / threads;
+
+            for (size_t i = begin; i < end; ++i)
+            {
+                double cx = (r[0][i] - m_min[0]) * m_invCell[0];
+                double cy = (r[1][i] - m_min[1]) * m_invCell[1];
+
+                // also false for NaN
+                if (!((cx >= 0) && (cx < double(m_width)) && (cy >= 0) && (cy < double(m_height))))
+                    continue;
+
+                size_t cell = size_t(cy) * m_width + size_t(cx);
+
+                counts[cell] += 1;
+
+                if (weigh && (i < weights.size()))
+                    sums[cell] += weights[i];
+            }
+        });
+
+        m_pool->ParallelFor(0, cells, [&](size_t begin, size_t end, size_t)
+        {
+            for (size_t cell = begin; cell < end; ++cell)
+            {
+                double count = 0, sum = 0;
+
+                for (size_t t = 0; t < threads; ++t)
+                {
+                    count += m_partCounts[t][cell];
+                    sum   += weigh ? m_partSums[t][cell] : 0;
+                }
+
+                m_counts[cell] = count;
+                m_sums[cell]   = sum;
+            }
+        });
+    };
+
+    //*****************************************************************************************************
+    // GetWidth() - get number of cells along x
+    //*****************************************************************************************************
+    //! @return number of cells
+    //*****************************************************************************************************
+    size_t GetWidth() const
+    {
+        return m_width;
+    };
+
+    //*****************************************************************************************************
+    // GetHeight() - get number of cells along y
+    //*****************************************************************************************************
+    //! @return number of cells
+    //*****************************************************************************************************
+    size_t GetHeight() const
+    {
+        return m_height;
+    };
+
+    //*****************************************************************************************************
+    // GetCount() - get number of particles in cell
+    //*****************************************************************************************************
+    //! @param [in] x index of cell along x
+    //! @param [in] y index of cell along y
+    //! @return number of particles
+    //*****************************************************************************************************
+    double GetCount(size_t x, size_t y) const
+    {
+        return m_counts[y * m_width + x];
+    };
+
+    //*****************************************************************************************************
+    // GetMean() - get mean weight of particles in cell
+    //*****************************************************************************************************
+    //! @param [in] x index of cell along x
+    //! @param [in] y index of cell along y
+    //! @return mean weight, NaN for an empty cell
+    //*****************************************************************************************************
+    double GetMean(size_t x, size_t y) const
+    {
+        double count = m_counts[y * m_width + x];
+
+        return (count > 0) ? m_sums[y * m_width + x] / count : std::numeric_limits<double>::quiet_NaN();
+    };
+};
+
+#endif    // DENSITY_MAP_H
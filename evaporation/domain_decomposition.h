@@ -0,0 +1,636 @@
+#ifndef DOMAIN_DECOMPOSITION_H
+#define DOMAIN_DECOMPOSITION_H
+
+#include "large_system.h"
+
+#include <mpi.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+//*********************************************************************************************************
+// DomainSystem - LargeSystem split into slabs along the x axis between MPI processes of one host
+//*********************************************************************************************************
+// Every rank owns atoms with x in its slab, the edge ranks of open and reflecting areas also own
+// atoms which left the area. After the drift atoms which crossed a slab face migrate to the
+// neighbour, then atoms closer than the cutoff to a face are sent to the neighbour as ghosts,
+// which only take part in forces. Slabs are not narrower than the cutoff, so atoms migrate at most
+// one slab per step and ghosts come from the nearest neighbours only. With one rank it is the plain
+// LargeSystem. All ranks have to call the methods in the same order, like MPI collectives.
+//*********************************************************************************************************
+template <size_t Dim>
+class DomainSystem
+{
+public:     // types
+
+    using System = LargeSystem<Dim>;                                                 //!< Engine of one domain
+
+private:    // variables
+
+    System              m_system;                                                    //!< Own atoms and ghosts
+
+    MPI_Comm            m_comm      = MPI_COMM_NULL;                                 //!< Communicator of the ranks
+    int                 m_rank      = 0;                                             //!< Index of this rank
+    int                 m_ranks     = 1;                                             //!< Number of ranks
+    int                 m_left      = MPI_PROC_NULL;                                 //!< Rank of the slab on the left
+    int                 m_right     = MPI_PROC_NULL;                                 //!< Rank of the slab on the right
+
+    double              m_slabMin   = 0;                                             //!< Left face of own slab
+    double              m_slabMax   = 0;                                             //!< Right face of own slab
+    double              m_slabWidth = 0;                                             //!< Width of every slab
+
+    std::vector<double> m_sendLeft;                                                  //!< Packed atoms for the left neighbour
+    std::vector<double> m_sendRight;                                                 //!< Packed atoms for the right neighbour
+    std::vector<double> m_receive;                                                   //!< Packed atoms from a neighbour
+
+    double              m_elapsed   = 0;                                             //!< Wall time of Process() in ns
+    double              m_atomSteps = 0;                                             //!< Number of processed atom steps of all ranks
+
+public:     // methods
+
+    //*****************************************************************************************************
+    // Constructor
+    //*****************************************************************************************************
+    //! @param [in, optional] comm communicator of ranks sharing the area, MPI has to be initialized
+    //*****************************************************************************************************
+    explicit DomainSystem(MPI_Comm comm = MPI_COMM_WORLD)
+    {
+        MPI_Comm_dup(comm, &m_comm);
+        MPI_Comm_rank(m_comm, &m_rank);
+        MPI_Comm_size(m_comm, &m_ranks);
+
+        // all ranks build the same initial state
+        uint64_t seed = std::random_device{}();
+
+        MPI_Bcast(&seed, 1, MPI_UINT64_T, 0, m_comm);
+        m_system.SetSeed(seed);
+    };
+
+    //*****************************************************************************************************
+    // Destructor
+    //*****************************************************************************************************
+    ~DomainSystem()
+    {
+        MPI_Comm_free(&m_comm);
+    };
+
+    DomainSystem(const DomainSystem&)            = delete;
+    DomainSystem& operator=(const DomainSystem&) = delete;
+
+    //*****************************************************************************************************
+    // GetRank() - get index of this rank
+    //*****************************************************************************************************
+    //! @return index of rank
+    //*****************************************************************************************************
+    int GetRank()
+    {
+        return m_rank;
+    };
+
+    //*****************************************************************************************************
+    // GetRanksAmount() - get number of ranks
+    //*****************************************************************************************************
+    //! @return number of ranks
+    //*****************************************************************************************************
+    int GetRanksAmount()
+    {
+        return m_ranks;
+    };
+
+    //*****************************************************************************************************
+    // SetThreads() - set number of threads of this rank
+    //*****************************************************************************************************
+    //! @param [in] threads number of threads including the caller, 0 means hardware concurrency
+    //*****************************************************************************************************
+    void SetThreads(size_t threads)
+    {
+        m_system.SetThreads(threads);
+    };
+
+    //*****************************************************************************************************
+    // SetTemperature() - set initial temperature in K
+    //*****************************************************************************************************
+    //! @param [in] t value of init temperature in K
+    //*****************************************************************************************************
+    void SetTemperature(double t)
+    {
+        m_system.SetTemperature(t);
+    };
+
+    //*****************************************************************************************************
+    // SetSeed() - seed generator of initial velocities, same value is expected on all ranks
+    //*****************************************************************************************************
+    //! @param [in] seed value of seed
+    //*****************************************************************************************************
+    void SetSeed(uint64_t seed)
+    {
+        m_system.SetSeed(seed);
+    };
+
+    //*****************************************************************************************************
+    // SetCutoff() - set cutoff distance of the potential
+    //*****************************************************************************************************
+    //! @param [in] cutoff distance in sigma
+    //*****************************************************************************************************
+    void SetCutoff(double cutoff)
+    {
+        m_system.SetCutoff(cutoff);
+    };
+
+    //*****************************************************************************************************
+    // SetSortInterval() - set number of steps between reorderings of particles by cells
+    //*****************************************************************************************************
+    //! @param [in] steps number of steps, 0 disables reordering
+    //*****************************************************************************************************
+    void SetSortInterval(uint32_t steps)
+    {
+        m_system.SetSortInterval(steps);
+    };
+
+    //*****************************************************************************************************
+    // EvaluateTimeStep() - evaluate time step funtion, same as Model::EvaluateTimeStep()
+    //*****************************************************************************************************
+    //! @param [in, optional] factor value of factor of time step for adjustment
+    //*****************************************************************************************************
+    double EvaluateTimeStep(double factor = 0.01)
+    {
+        return m_system.EvaluateTimeStep(factor);
+    };
+
+    //*****************************************************************************************************
+    // GetEquilibriumDistance() - get equilibrium distanse between particles function
+    //*****************************************************************************************************
+    //! @return equilibrium distance
+    //*****************************************************************************************************
+    double GetEquilibriumDistance()
+    {
+        return m_system.GetEquilibriumDistance();
+    };
+
+    //*****************************************************************************************************
+    // SetBoundaries() - set type of boundaries of the modeling area
+    //*****************************************************************************************************
+    //! @param [in] boundary type of boundaries
+    //*****************************************************************************************************
+    void SetBoundaries(Boundary boundary)
+    {
+        m_system.SetBoundaries(boundary);
+    };
+
+    //*****************************************************************************************************
+    // SetModelingSpace() - set size of the whole modeling area
+    //*****************************************************************************************************
+    //! @param [in] sizes width, height (and depth) of the area in m
+    //*****************************************************************************************************
+    template <typename... Sizes>
+    void SetModelingSpace(Sizes... sizes)
+    {
+        m_system.SetModelingSpace(sizes...);
+    };
+
+    //*****************************************************************************************************
+    // SetInitialConditions() - set planar grid as initial conditions, same layout as Model
+    //*****************************************************************************************************
+    //! @param [in] width number of nodes along the y axis
+    //! @param [in] height number of nodes along the x axis
+    //! @param [in] period period of grid
+    //*****************************************************************************************************
+    void SetInitialConditions(int width, int height, double period)
+    {
+        m_system.SetInitialConditions(width, height, period);
+
+        split();
+    };
+
+    //*****************************************************************************************************
+    // SetInitialConditions() - set simple cubic grid as initial conditions, same layout as Model3D
+    //*****************************************************************************************************
+    //! @param [in] width number of nodes along the y axis
+    //! @param [in] height number of nodes along the x axis
+    //! @param [in] depth number of nodes along the z axis
+    //! @param [in] period period of grid
+    //*****************************************************************************************************
+    void SetInitialConditions(int width, int height, int depth, double period)
+    {
+        m_system.SetInitialConditions(width, height, depth, period);
+
+        split();
+    };
+
+    //*****************************************************************************************************
+    // Process() - process some iterations of modeling function
+    //*****************************************************************************************************
+    //! @param [in] iterations value of iterations to process
+    //*****************************************************************************************************
+    void Process(uint32_t iterations)
+    {
+        auto begin = std::chrono::steady_clock::now();
+
+        for (uint32_t i = 0; i < iterations; ++i)
+            Process();
+
+        m_elapsed   += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+        m_atomSteps += double(iterations) * GetParticlesAmount();
+    };
+
+    //*****************************************************************************************************
+    // Process() - process one iteration, LargeSystem::Process() with exchanges between ranks
+    //*****************************************************************************************************
+    void Process()
+    {
+        if (m_ranks == 1)
+        {
+            m_system.Process();
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_system.protection_mutex);
+
+            m_system.kick_drift();
+            m_system.resize(m_system.m_owned, m_system.m_owned);
+
+            migrate();
+
+            uint32_t interval = m_system.m_sortInterval;
+
+            if ((interval > 0) && (m_system.m_iter % interval == 0))
+                m_system.sort_by_cells(true);
+
+            exchange_ghosts();
+            m_system.sort_by_cells(false);
+        }
+
+        m_system.m_pE     = m_system.forces();
+        m_system.m_pESum += m_system.m_pE;
+
+        m_system.kick();
+    };
+
+    //*****************************************************************************************************
+    // ReadPositions() - pass coordinates of own particles to reader under the lock
+    //*****************************************************************************************************
+    //! @param [in] reader function called as reader(std::array<const double*, Dim>, size_t)
+    //*****************************************************************************************************
+    template <typename Reader>
+    void ReadPositions(Reader&& reader)
+    {
+        m_system.ReadPositions(reader);
+    };
+
+    //*****************************************************************************************************
+    // GetPotentialEnergySum() - get potensial energy sum of all ranks and set p.e. as zero
+    //*****************************************************************************************************
+    //! @return potential energy sum
+    //*****************************************************************************************************
+    double GetPotentialEnergySum()
+    {
+        return sum(m_system.GetPotentialEnergySum());
+    };
+
+    //*****************************************************************************************************
+    // GetKineticEnergySum() - get kinetic energy sum of all ranks and set k.e. as zero
+    //*****************************************************************************************************
+    //! @return kinetic energy sum
+    //*****************************************************************************************************
+    double GetKineticEnergySum()
+    {
+        return sum(m_system.GetKineticEnergySum());
+    };
+
+    //*****************************************************************************************************
+    // GetTemperature() - get temperature of all ranks on the last iteration in K
+    //*****************************************************************************************************
+    //! @return temperature in Kelvin
+    //*****************************************************************************************************
+    double GetTemperature()
+    {
+        double amount = double(GetParticlesAmount());
+        double own    = double(m_system.GetParticlesAmount());
+
+        // temperatures of ranks weighted by their numbers of atoms
+        return (amount > 0) ? sum(m_system.GetTemperature() * own) / amount : 0;
+    };
+
+    //*****************************************************************************************************
+    // GetParticlesLoss() - get cur value of particles out of modeling space on all ranks
+    //*****************************************************************************************************
+    //! @return number of lost particles
+    //*****************************************************************************************************
+    uint32_t GetParticlesLoss()
+    {
+        return uint32_t(sum(m_system.GetParticlesLoss()));
+    };
+
+    //*****************************************************************************************************
+    // GetParticlesAmount() - get number of particles of all ranks
+    //*****************************************************************************************************
+    //! @return number of particles
+    //*****************************************************************************************************
+    size_t GetParticlesAmount()
+    {
+        return size_t(sum(double(m_system.GetParticlesAmount())));
+    };
+
+    //*****************************************************************************************************
+    // GetOwnParticlesAmount() - get number of particles owned by this rank
+    //*****************************************************************************************************
+    //! @return number of particles
+    //*****************************************************************************************************
+    size_t GetOwnParticlesAmount()
+    {
+        return m_system.GetParticlesAmount();
+    };
+
+    //*****************************************************************************************************
+    // GetGhostsAmount() - get number of ghosts received by this rank on the last iteration
+    //*****************************************************************************************************
+    //! @return number of ghosts
+    //*****************************************************************************************************
+    size_t GetGhostsAmount()
+    {
+        return m_system.m_size - m_system.m_owned;
+    };
+
+    //*****************************************************************************************************
+    // GetIteration() - get cur value of iteration function
+    //*****************************************************************************************************
+    //! @return value of cur iteration
+    //*****************************************************************************************************
+    uint32_t GetIteration()
+    {
+        return m_system.GetIteration();
+    };
+
+    //*****************************************************************************************************
+    // GetNsPerAtomStep() - get mean wall time of one step of one atom of the whole system in Process()
+    //*****************************************************************************************************
+    //! @return time in ns
+    //*****************************************************************************************************
+    double GetNsPerAtomStep()
+    {
+        return (m_atomSteps > 0) ? m_elapsed / m_atomSteps : 0;
+    };
+
+private:    // methods
+
+    //*****************************************************************************************************
+    // sum() - sum of values of all ranks
+    //*****************************************************************************************************
+    //! @param [in] value value of this rank
+    //! @return sum
+    //*****************************************************************************************************
+    double sum(double value)
+    {
+        double total = value;
+
+        if (m_ranks > 1)
+            MPI_Allreduce(&value, &total, 1, MPI_DOUBLE, MPI_SUM, m_comm);
+
+        return total;
+    };
+
+    //*****************************************************************************************************
+    // split() - keep atoms of own slab and set cell grid of the slab with margins for ghosts
+    //*****************************************************************************************************
+    // Slabs narrower than the cutoff can not be exchanged with the nearest neighbours only,
+    // in this case the system is left empty on all ranks.
+    //*****************************************************************************************************
+    void split()
+    {
+        if (m_ranks == 1)
+            return;
+
+        System& s = m_system;
+
+        m_slabWidth = (s.m_spaceMax[0] - s.m_spaceMin[0]) / m_ranks;
+        m_slabMin   = s.m_spaceMin[0] + m_rank * m_slabWidth;
+        m_slabMax   = m_slabMin + m_slabWidth;
+
+        bool periodic = (s.m_boundary == Boundary::Periodic);
+
+        m_left  = (m_rank > 0)           ? m_rank - 1 : (periodic ? m_ranks - 1 : MPI_PROC_NULL);
+        m_right = (m_rank + 1 < m_ranks) ? m_rank + 1 : (periodic ? 0           : MPI_PROC_NULL);
+
+        if (m_slabWidth < s.m_cutoff)
+        {
+            s.resize(0, 0);
+            return;
+        }
+
+        size_t owned = 0;
+
+        for (size_t i = 0; i < s.m_owned; ++i)
+            if (owner(s.m_r[0][i]) == m_rank)
+                move(i, owned++);
+
+        s.resize(owned, owned);
+
+        // ghosts bring images across the periodic faces along x, so cells and minimum image are not
+        // wrapped there, positions still are by m_invWrap and go to the rank of the wrapped slab
+        s.m_invPeriod[0] = 0;
+        s.m_gridMin[0]   = m_slabMin - s.m_cutoff;
+        s.m_gridMax[0]   = m_slabMax + s.m_cutoff;
+
+        s.set_cells();
+
+        {
+            std::lock_guard<std::mutex> lock(s.protection_mutex);
+
+            s.sort_by_cells(true);
+            exchange_ghosts();
+            s.sort_by_cells(false);
+        }
+
+        s.m_pE = s.forces();
+    };
+
+    //*****************************************************************************************************
+    // owner() - rank which owns atom with given x
+    //*****************************************************************************************************
+    //! @param [in] x coordinate along the x axis
+    //! @return index of rank
+    //*****************************************************************************************************
+    int owner(double x) const
+    {
+        double slab = std::floor((x - m_system.m_spaceMin[0]) / m_slabWidth);
+
+        return int(std::clamp(slab, 0.0, double(m_ranks - 1)));
+    };
+
+    //*****************************************************************************************************
+    // move() - copy data of own atom to other index
+    //*****************************************************************************************************
+    //! @param [in] from index of atom
+    //! @param [in] to new index of atom
+    //*****************************************************************************************************
+    void move(size_t from, size_t to)
+    {
+        for (size_t k = 0; k < Dim; ++k)
+        {
+            m_system.m_r[k][to] = m_system.m_r[k][from];
+            m_system.m_v[k][to] = m_system.m_v[k][from];
+            m_system.m_a[k][to] = m_system.m_a[k][from];
+        }
+    };
+
+    //*****************************************************************************************************
+    // pack() - append coordinates and optionally velocities of atom to buffer
+    //*****************************************************************************************************
+    //! @param [in] buffer buffer for neighbour
+    //! @param [in] i index of atom
+    //! @param [in] shift shift of x across the periodic face
+    //! @param [in] velocities append velocities too
+    //*****************************************************************************************************
+    void pack(std::vector<double>& buffer, size_t i, double shift, bool velocities)
+    {
+        buffer.push_back(m_system.m_r[0][i] + shift);
+
+        for (size_t k = 1; k < Dim; ++k)
+            buffer.push_back(m_system.m_r[k][i]);
+
+        if (velocities)
+            for (size_t k = 0; k < Dim; ++k)
+                buffer.push_back(m_system.m_v[k][i]);
+    };
+
+    //*****************************************************************************************************
+    // unpack() - append atoms from m_receive after the last atom
+    //*****************************************************************************************************
+    //! @param [in] velocities buffer has velocities too
+    //! @param [in] owned received atoms become own atoms
+    //*****************************************************************************************************
+    void unpack(bool velocities, bool owned)
+    {
+        System& s = m_system;
+
+        size_t values = velocities ? 2 * Dim : Dim;
+        size_t first  = s.m_size;
+        size_t count  = m_receive.size() / values;
+
+        s.resize(first + count, owned ? s.m_owned + count : s.m_owned);
+
+        for (size_t n = 0; n < count; ++n)
+        {
+            const double* atom = &m_receive[n * values];
+
+            for (size_t k = 0; k < Dim; ++k)
+            {
+                s.m_r[k][first + n] = atom[k];
+                s.m_v[k][first + n] = velocities ? atom[Dim + k] : 0;
+                s.m_a[k][first + n] = 0;
+            }
+        }
+    };
+
+    //*****************************************************************************************************
+    // exchange() - send buffer to one neighbour and receive m_receive from the other one
+    //*****************************************************************************************************
+    //! @param [in] send packed atoms
+    //! @param [in] to rank to send to
+    //! @param [in] from rank to receive from
+    //*****************************************************************************************************
+    void exchange(const std::vector<double>& send, int to, int from)
+    {
+        int count    = int(send.size());
+        int incoming = 0;
+
+        MPI_Sendrecv(&count, 1, MPI_INT, to, 0, &incoming, 1, MPI_INT, from, 0, m_comm, MPI_STATUS_IGNORE);
+
+        m_receive.resize(size_t(incoming));
+
+        MPI_Sendrecv(send.data(), count, MPI_DOUBLE, to, 1, m_receive.data(), incoming, MPI_DOUBLE, from, 1, m_comm, MPI_STATUS_IGNORE);
+    };
+
+    //*****************************************************************************************************
+    // shift() - shift of x of atom sent to the neighbour across the periodic face
+    //*****************************************************************************************************
+    //! @param [in] right atom goes to the right neighbour
+    //! @return shift
+    //*****************************************************************************************************
+    double shift(bool right) const
+    {
+        double period = m_system.m_period[0];
+
+        if (right)
+            return (m_rank + 1 == m_ranks) ? - period : 0;
+
+        return (m_rank == 0) ? period : 0;
+    };
+
+    //*****************************************************************************************************
+    // migrate() - send atoms which left own slab to the neighbours, there are no ghosts here
+    //*****************************************************************************************************
+    void migrate()
+    {
+        System& s = m_system;
+
+        m_sendLeft.clear();
+        m_sendRight.clear();
+
+        size_t owned = 0;
+
+        for (size_t i = 0; i < s.m_owned; ++i)
+        {
+            int to = owner(s.m_r[0][i]);
+
+            if (to == m_rank)
+            {
+                move(i, owned++);
+                continue;
+            }
+
+            // kick_drift() wrapped positions by the global period, so the nearest way round the ring is taken
+            int  forward = (to - m_rank + m_ranks) % m_ranks;
+            bool right   = (m_left == MPI_PROC_NULL) || ((m_right != MPI_PROC_NULL) && (forward <= m_ranks / 2));
+
+            if (s.m_boundary != Boundary::Periodic)
+                right = (to > m_rank);
+
+            pack(right ? m_sendRight : m_sendLeft, i, 0, true);
+        }
+
+        s.resize(owned, owned);
+
+        exchange(m_sendRight, m_right, m_left);
+        unpack(true, true);
+
+        exchange(m_sendLeft, m_left, m_right);
+        unpack(true, true);
+    };
+
+    //*****************************************************************************************************
+    // exchange_ghosts() - send copies of own atoms near slab faces to the neighbours
+    //*****************************************************************************************************
+    void exchange_ghosts()
+    {
+        System& s = m_system;
+
+        m_sendLeft.clear();
+        m_sendRight.clear();
+
+        for (size_t i = 0; i < s.m_owned; ++i)
+        {
+            double x = s.m_r[0][i];
+
+            if ((m_left != MPI_PROC_NULL) && (x < m_slabMin + s.m_cutoff))
+                pack(m_sendLeft, i, shift(false), false);
+
+            if ((m_right != MPI_PROC_NULL) && (x >= m_slabMax - s.m_cutoff))
+                pack(m_sendRight, i, shift(true), false);
+        }
+
+        exchange(m_sendRight, m_right, m_left);
+        unpack(false, false);
+
+        exchange(m_sendLeft, m_left, m_right);
+        unpack(false, false);
+    };
+};
+
+#endif    // DOMAIN_DECOMPOSITION_H
@@ -1,6 +1,10 @@
 #ifndef EVAPORATION_H
 #define EVAPORATION_H
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
@@ -9,18 +13,64 @@
 #include <mutex>
 #include <random>
 
-struct Particle
+#include "random.h"
+#include "span.h"
+#include "statistics.h"
+
+//*********************************************************************************************************
+// TimeStepRecord - one entry of the adaptive time step history
+//*********************************************************************************************************
+struct TimeStepRecord
+{
+    uint32_t m_iteration;          //!< Iteration at the end of the block
+    double   m_timestep;           //!< Time step used for the block
+    double   m_drift;              //!< Energy change over the block per particle in units of the well depth
+    double   m_displacement;       //!< Largest estimated displacement per step in sigma
+};
+
+//*********************************************************************************************************
+// PerformanceCounters - totals of work and waits of a model since its creation
+//*********************************************************************************************************
+// Counters only grow, rates are differences of two readings divided by the time between them.
+//*********************************************************************************************************
+struct PerformanceCounters
+{
+    uint64_t m_iterations      = 0;    //!< Processed iterations
+    uint64_t m_particleSteps   = 0;    //!< Sum of numbers of particles over processed iterations
+    uint64_t m_processTime     = 0;    //!< Time spent in Process() in ns
+    uint64_t m_pairEvaluations = 0;    //!< Evaluated pair interactions
+    uint64_t m_lockWaits       = 0;    //!< Locks of data which had to wait for another thread
+    uint64_t m_lockWaitTime    = 0;    //!< Time spent waiting for the lock of data in ns
+    uint64_t m_publications    = 0;    //!< Published snapshots
+    uint64_t m_publishTime     = 0;    //!< Time spent copying snapshots in ns
+};
+
+//*********************************************************************************************************
+// squared_norm() - squared length of vector
+//*********************************************************************************************************
+//! @param [in] v vector
+//! @return sum of squares of components
+//*********************************************************************************************************
+template <size_t Dim>
+inline double squared_norm(const std::array<double, Dim>& v)
+{
+    double sum = 0;
+
+    for (size_t k = 0; k < Dim; ++k)
+        sum += v[k] * v[k];
+
+    return sum;
+}
+
+template <size_t Dim>
+struct BasicParticle
 {
 public:    // variables
 
-    double                  m_x           = 0;                             //!< Value of x coordinate
-    double                  m_y           = 0;                             //!< Value of y coordinate
-    double                  m_vX          = 0;                             //!< Value of x velocity
-    double                  m_vY          = 0;                             //!< Value of y velocity
-    double                  m_aX          = 0;                             //!< Current value of x acceleration
-    double                  m_aY          = 0;                             //!< Current value of y acceleration
-    double                  m_aX_previous = 0;                             //!< Previous value of x acceleration
-    double                  m_aY_previous = 0;                             //!< Previous value of y acceleration
+    std::array<double, Dim> m_r           = {};                            //!< Values of coordinates
+    std::array<double, Dim> m_v           = {};                            //!< Values of velocities
+    std::array<double, Dim> m_a           = {};                            //!< Current values of accelerations
+    std::array<double, Dim> m_a_previous  = {};                            //!< Previous values of accelerations
     constexpr static double m_m           = 39.948 * 1.66053906660E-27;    //!< Mass of particle
     double                  m_vSum        = 0;                             //!< Summ of velocity modul
     uint32_t                m_counter     = 0;                             //!< Number of items in sum
@@ -28,15 +78,15 @@ public:    // variables
 public:    // methods
 
     // Default constructor
-    Particle(){};
+    BasicParticle(){};
 
     // Default destructor
-    ~Particle(){};
+    ~BasicParticle(){};
 
     // Add velocity to sum function
     void AddVelocityInSum()
     {
-        m_vSum += m_vX * m_vX + m_vY * m_vY;
+        m_vSum += squared_norm(m_v);
         ++m_counter;
     };
 
@@ -55,8 +105,217 @@ public:    // methods
     };
 };
 
-class Model
+using Particle   = BasicParticle<2>;
+using Particle3D = BasicParticle<3>;
+
+//*********************************************************************************************************
+// Integrator - time integration scheme used by Model::Process()
+//*********************************************************************************************************
+enum class Integrator
+{
+    VelocityVerlet,    //!< Velocity Verlet with all forces every step
+    Respa              //!< Multiple time step: short-range forces on inner steps, the rest on outer steps
+};
+
+//*********************************************************************************************************
+// Thermostat - temperature control applied after every iteration of Model::Process()
+//*********************************************************************************************************
+enum class Thermostat
+{
+    None,          //!< Microcanonical run
+    Berendsen,     //!< Velocity rescaling towards target temperature
+    Langevin,      //!< Friction and random kicks, exact Ornstein-Uhlenbeck update of velocities
+    NoseHoover     //!< Nose-Hoover chain
+};
+
+//*********************************************************************************************************
+// Boundary - behaviour of particles at the walls of the modeling area
+//*********************************************************************************************************
+enum class Boundary
+{
+    Open,          //!< Particles leave the area and are counted as lost
+    Periodic,      //!< Periodic boundaries with minimum image convention
+    Reflecting     //!< Particles are elastically reflected by the walls
+};
+
+template <size_t W>
+class ReplicaBatch;
+
+template <size_t Dim>
+class LargeSystem;
+
+//*********************************************************************************************************
+// BasicModel - molecular dynamics of argon atoms in Dim dimensions
+//*********************************************************************************************************
+// Model is the planar engine used by the GUI and the analysis, Model3D is the spatial one.
+//*********************************************************************************************************
+template <size_t Dim>
+class BasicModel
 {
+    static_assert((Dim == 2) || (Dim == 3), "only 2D and 3D models are supported");
+
+    template <size_t W>
+    friend class ReplicaBatch;
+
+    template <size_t D>
+    friend class LargeSystem;
+
+public:     // types
+
+    using ParticleType = BasicParticle<Dim>;                                         //!< Type of particle
+    using Vector       = std::array<double, Dim>;                                    //!< Point or vector in modeling space
+
+    //*****************************************************************************************************
+    // PositionsView - read-only view of coordinates published by ObserveParticlePositions()
+    //*****************************************************************************************************
+    // The view points into a snapshot of the model, nothing is copied. The model writes a snapshot
+    // again after two more publications, IsValid() tells whether it has started to do so, then values
+    // read since the view was taken may be torn and have to be dropped.
+    //*****************************************************************************************************
+    class PositionsView
+    {
+    private:    // variables
+
+        std::array<Span<const double>, Dim> m_r;                                     //!< Coordinates, one span per axis
+        uint32_t                            m_iteration = 0;                         //!< Iteration of the snapshot
+        uint64_t                            m_stamp     = 0;                         //!< Sequence of the snapshot when taken
+        const std::atomic<uint64_t>*        m_sequence  = nullptr;                   //!< Sequence of the snapshot now
+        std::chrono::steady_clock::time_point m_publicationTime;                     //!< Time of publication
+        double                              m_simulatedTime = 0;                     //!< Simulated time of the snapshot in s
+        double                              m_timestep      = 0;                     //!< Time step at the snapshot in s
+
+    public:     // methods
+
+        PositionsView() = default;
+
+        PositionsView(const std::array<Span<const double>, Dim>& r, uint32_t iteration,
+                      uint64_t stamp, const std::atomic<uint64_t>* sequence,
+                      std::chrono::steady_clock::time_point time = {},
+                      double simulatedTime = 0, double timestep = 0)
+            : m_r(r)
+            , m_iteration(iteration)
+            , m_stamp(stamp)
+            , m_sequence(sequence)
+            , m_publicationTime(time)
+            , m_simulatedTime(simulatedTime)
+            , m_timestep(timestep)
+        {
+        };
+
+        //*************************************************************************************************
+        // operator[] - get coordinates along one axis
+        //*************************************************************************************************
+        //! @param [in] k index of axis
+        //! @return coordinates of all particles
+        //*************************************************************************************************
+        const Span<const double>& operator[](size_t k) const
+        {
+            return m_r[k];
+        };
+
+        //*************************************************************************************************
+        // size() - get number of particles
+        //*************************************************************************************************
+        //! @return number of particles
+        //*************************************************************************************************
+        size_t size() const
+        {
+            return m_r[0].size();
+        };
+
+        //*************************************************************************************************
+        // GetIteration() - get iteration at which the snapshot was published
+        //*************************************************************************************************
+        //! @return iteration
+        //*************************************************************************************************
+        uint32_t GetIteration() const
+        {
+            return m_iteration;
+        };
+
+        //*************************************************************************************************
+        // GetSequence() - get number of the publication, equal numbers mean the same frame
+        //*************************************************************************************************
+        //! @return number of publication, 0 before the first one
+        //*************************************************************************************************
+        uint64_t GetSequence() const
+        {
+            return m_stamp / 2;
+        };
+
+        //*************************************************************************************************
+        // GetPublicationTime() - get time at which the snapshot was published
+        //*************************************************************************************************
+        //! @return time of publication, its difference with now is the latency of the frame
+        //*************************************************************************************************
+        std::chrono::steady_clock::time_point GetPublicationTime() const
+        {
+            return m_publicationTime;
+        };
+
+        //*************************************************************************************************
+        // GetSimulatedTime() - get simulated time of the snapshot
+        //*************************************************************************************************
+        //! @return time in s, 0 if the source does not keep it
+        //*************************************************************************************************
+        double GetSimulatedTime() const
+        {
+            return m_simulatedTime;
+        };
+
+        //*************************************************************************************************
+        // GetTimeStep() - get time step at which the snapshot was published
+        //*************************************************************************************************
+        //! @return time step in s, 0 if the source does not keep it
+        //*************************************************************************************************
+        double GetTimeStep() const
+        {
+            return m_timestep;
+        };
+
+        //*************************************************************************************************
+        // IsValid() - check that the snapshot has not been overwritten since the view was taken
+        //*************************************************************************************************
+        //! @return true if values read so far are consistent
+        //*************************************************************************************************
+        bool IsValid() const
+        {
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            return (m_sequence == nullptr) || (m_sequence->load(std::memory_order_relaxed) == m_stamp);
+        };
+    };
+
+private:    // types
+
+    //*****************************************************************************************************
+    // Snapshot - coordinates of particles published after Process()
+    //*****************************************************************************************************
+    struct Snapshot
+    {
+        std::array<std::vector<double>, Dim> m_r;                                    //!< Coordinates, one array per axis
+        uint32_t                             m_iteration = 0;                        //!< Iteration of the snapshot
+        double                               m_time      = 0;                        //!< Simulated time of the snapshot in s
+        double                               m_timestep  = 0;                        //!< Time step at the snapshot in s
+        std::chrono::steady_clock::time_point m_publicationTime;                     //!< Time of publication
+        std::atomic<uint64_t>                m_sequence{0};                          //!< Twice the publication number, odd while written
+    };
+
+    //*****************************************************************************************************
+    // Counters - performance counters updated by the model, read by any thread
+    //*****************************************************************************************************
+    struct Counters
+    {
+        std::atomic<uint64_t> m_iterations{0};                                       //!< Processed iterations
+        std::atomic<uint64_t> m_particleSteps{0};                                    //!< Sum of numbers of particles over iterations
+        std::atomic<uint64_t> m_processTime{0};                                      //!< Time spent in Process() in ns
+        std::atomic<uint64_t> m_pairEvaluations{0};                                  //!< Evaluated pair interactions
+        std::atomic<uint64_t> m_lockWaits{0};                                        //!< Locks which had to wait
+        std::atomic<uint64_t> m_lockWaitTime{0};                                     //!< Time spent waiting for locks in ns
+        std::atomic<uint64_t> m_publications{0};                                     //!< Published snapshots
+        std::atomic<uint64_t> m_publishTime{0};                                      //!< Time spent copying snapshots in ns
+    };
+
 private:    // variables
 
     constexpr static double m_sigma                = 0.382 * 1E-9;                   //!< Distance between atomic centers
@@ -67,37 +326,85 @@ private:    // variables
                                                                                      //!< of interaction between atoms at equilibrium
 
     constexpr static double m_boltzman             = 1.38E-23;
-    std::vector<Particle>   m_particles;                                             //!< Array with particles
+    std::vector<ParticleType> m_particles;                                           //!< Array with particles
+
+    Vector    m_spaceMin         = {};                                               //!< Position of the left, bot (and near) walls of the modeling area
+    Vector    m_spaceMax         = filled(30 * m_equilibrium_distance);              //!< Position of the right, top (and far) walls of the modeling area
 
-    double    m_spaceLeft        = 0;                                                //!< Position of the left wall of the modeling area
-    double    m_spaceRight       = 30 * m_equilibrium_distance;                      //!< Position of the right wall of the modeling area
-    double    m_spaceTop         = 30 * m_equilibrium_distance;                      //!< Position of the top wall of the modeling area
-    double    m_spaceBot         = 0;                                                //!< Position of the bot wall of the modeling area
-    double    m_spaceWidthHalf   = (m_spaceRight - m_spaceLeft) / 2;                 //!< Value of half space width
-    double    m_spaceHeightHalf  = (m_spaceTop - m_spaceBot) / 2;                    //!< Value of half space height
+    Boundary  m_boundary         = Boundary::Open;                                   //!< Type of boundaries
+    Vector    m_period           = {};                                               //!< Periods for minimum image
+    Vector    m_invPeriod        = {};                                               //!< Inverse periods, 0 along not periodic axes
 
     double    m_maxIter    = 5000;                                                   //!< Max value of iterations
     double    m_iter       = 0;                                                      //!< Current value of iterations
     double    m_timestep   = 0;                                                      //!< Time step of modeling
     double    m_kESum      = 0;                                                      //!< Kinetic energy sum
     double    m_pESum      = 0;                                                      //!< Potencial energy sum
+    double    m_kE         = 0;                                                      //!< Kinetic energy on the last iteration
+    double    m_pE         = 0;                                                      //!< Potencial energy on the last iteration
+    double    m_time       = 0;                                                      //!< Simulated time
+    double    m_maxV2      = 0;                                                      //!< Largest squared velocity since the last reset
+    double    m_maxA2      = 0;                                                      //!< Largest squared acceleration since the last reset
 
     double    m_temp       = 1;                                                      //!< Init temprature in K
 
     std::mutex protection_mutex;                                                     //!< Mutex for data
+    Counters   m_counters;                                                           //!< Performance counters
+
+    std::array<Snapshot, 3> m_snapshots;                                             //!< Published, previous and written snapshots
+    std::atomic<uint32_t>   m_published{0};                                          //!< Index of the last published snapshot
+    uint64_t                m_publications = 0;                                      //!< Number of publications
     std::random_device rd;                                                           //!< random device for setting initial velocities
 
+    constexpr static size_t m_tileSize       = 16;                                   //!< Number of particles in one block of the tiled kernel
+    size_t    m_tiledThreshold               = 1024;                                 //!< Max number of particles for which the tiled kernel is used
+    std::array<std::vector<double>, Dim> m_tileR;                                    //!< Scratch coordinates for the tiled kernel
+    std::array<std::vector<double>, Dim> m_tileF;                                    //!< Scratch forces for the tiled kernel
+
+    Integrator m_integrator      = Integrator::VelocityVerlet;                       //!< Current integration scheme
+    uint32_t   m_respaSteps      = 4;                                                //!< Number of inner RESPA steps per outer step
+    double     m_respaInner      = 1.6 * m_sigma;                                    //!< Distance where the slow force starts to switch on
+    double     m_respaOuter      = 2.0 * m_sigma;                                    //!< Distance beyond which the whole force is slow
+    double     m_respaSkin       = 0.5 * m_sigma;                                    //!< Extra distance for the list of fast pairs
+    bool       m_respaReady      = false;                                            //!< Fast and slow forces are valid for current positions
+    std::vector<std::pair<uint32_t, uint32_t>> m_respaPairs;                         //!< Pairs which may feel the fast force
+    std::array<std::vector<double>, Dim> m_fastA;                                    //!< Fast accelerations
+    std::array<std::vector<double>, Dim> m_slowA;                                    //!< Slow accelerations
+
+    bool       m_adaptiveStep    = false;                                            //!< Time step is adjusted between blocks
+    uint32_t   m_adaptiveBlock   = 100;                                              //!< Number of iterations in one block
+    double     m_maxDisplacement = 0.05;                                             //!< Allowed displacement per step in sigma
+    double     m_driftBudget     = 1E-3;                                             //!< Allowed energy change per block and particle in depth
+    double     m_minFactor       = 0.001;                                            //!< Smallest time step factor
+    double     m_maxFactor       = 0.1;                                              //!< Largest time step factor
+    std::vector<TimeStepRecord> m_stepHistory;                                       //!< History of adaptive time steps
+
+    Thermostat m_thermostat      = Thermostat::None;                                 //!< Current thermostat
+    double     m_thermostatTemp  = 0;                                                //!< Target temperature of thermostat in K
+    double     m_thermostatTime  = 0;                                                //!< Coupling time of thermostat in s
+    NormalGenerator     m_normal{std::random_device{}()};                            //!< Generator of Langevin random kicks
+    std::vector<double> m_noise;                                                     //!< Normal numbers for one Langevin step
+    std::vector<double> m_chainXi;                                                   //!< Positions of Nose-Hoover chain thermostats
+    std::vector<double> m_chainVXi;                                                  //!< Velocities of Nose-Hoover chain thermostats
+    std::vector<double> m_chainQ;                                                    //!< Masses of Nose-Hoover chain thermostats
+    std::vector<double> m_chainG;                                                    //!< Forces of Nose-Hoover chain thermostats
+
+    BlockAverage m_temperatureStats;                                                 //!< Temperature of every iteration in K
+    BlockAverage m_kineticStats;                                                     //!< Kinetic energy of every iteration
+    BlockAverage m_potentialStats;                                                   //!< Potential energy of every iteration
+    BlockAverage m_energyStats;                                                      //!< Total energy of every iteration
+
 public:     // methods
 
     //*****************************************************************************************************
     // Default constructor
     //*****************************************************************************************************
-    Model() = default;
+    BasicModel() = default;
 
     //*****************************************************************************************************
     // Default destructor
     //*****************************************************************************************************
-    ~Model() = default;
+    ~BasicModel() = default;
 
     //*****************************************************************************************************
     // GetParticles() - get vector with particlues function
@@ -106,16 +413,37 @@ public:     // methods
     //*****************************************************************************************************
     auto GetParticles()
     {
-        std::lock_guard<std::mutex> lock(protection_mutex);
+        auto lock = lock_data();
 
         return m_particles;
     };
 
+    //*****************************************************************************************************
+    // FillParticles() - copy particles into buffer of the caller
+    //*****************************************************************************************************
+    //! @param [out] particles buffer, at most its size particles are copied
+    //! @return number of particles in the model
+    //*****************************************************************************************************
+    size_t FillParticles(Span<ParticleType> particles)
+    {
+        auto lock = lock_data();
+
+        size_t count = std::min(particles.size(), m_particles.size());
+
+        std::copy(m_particles.begin(), m_particles.begin() + count, particles.begin());
+
+        return m_particles.size();
+    };
+
 
-    bool InBounds(double x, double y)
+    bool InBounds(const Vector& r)
     {
-        return (x > m_spaceLeft) && (x < m_spaceRight) &&
-            (y > m_spaceBot) && (y < m_spaceTop);
+        bool in = true;
+
+        for (size_t k = 0; k < Dim; ++k)
+            in = in && (r[k] > m_spaceMin[k]) && (r[k] < m_spaceMax[k]);
+
+        return in;
     }
 
     //*****************************************************************************************************
@@ -146,25 +474,198 @@ public:     // methods
 
 
     //*****************************************************************************************************
-    // GetParticlesPositions() - get tuple with vectors of particlues positions function
+    // GetParticlesPositions() - get vectors of particlues positions function
     //*****************************************************************************************************
-    //! @return tuple with vectors of particles positions
+    //! @return array with one vector of particles coordinates per axis
     //*****************************************************************************************************
     auto GetParticlePositions()
     {
-        std::lock_guard<std::mutex> lock(protection_mutex);
+        auto lock = lock_data();
+
+        std::array<std::vector<double>, Dim> positions;
+        std::array<Span<double>, Dim>        spans;
+
+        for (size_t k = 0; k < Dim; ++k)
+        {
+            positions[k].resize(m_particles.size());
+            spans[k] = positions[k];
+        }
+
+        fill_positions(spans);
+
+        return positions;
+    };
+
+    //*****************************************************************************************************
+    // FillParticlePositions() - copy coordinates of particles into buffers of the caller
+    //*****************************************************************************************************
+    // Buffers kept by the caller between calls make snapshots free of allocations.
+    //*****************************************************************************************************
+    //! @param [out] positions one buffer per axis, at most the smallest size particles are copied
+    //! @return number of particles in the model
+    //*****************************************************************************************************
+    size_t FillParticlePositions(const std::array<Span<double>, Dim>& positions)
+    {
+        auto lock = lock_data();
+
+        fill_positions(positions);
+
+        return m_particles.size();
+    };
+
+    //*****************************************************************************************************
+    // ObserveParticlePositions() - get view of the last published coordinates without copying and locks
+    //*****************************************************************************************************
+    // Coordinates are published at the end of Process() and of setting initial conditions. Readers
+    // compare GetSequence() of views to skip frames they have seen and check IsValid() after reading.
+    // Views stay readable while the number of particles is not changed.
+    //*****************************************************************************************************
+    //! @return view of the snapshot
+    //*****************************************************************************************************
+    PositionsView ObserveParticlePositions()
+    {
+        while (true)
+        {
+            const Snapshot& snapshot = m_snapshots[m_published.load(std::memory_order_acquire)];
+
+            uint64_t stamp = snapshot.m_sequence.load(std::memory_order_acquire);
+
+            // the writer has already lapped the published snapshot, take the newer one
+            if (stamp % 2 != 0)
+                continue;
+
+            std::array<Span<const double>, Dim> r;
+
+            for (size_t k = 0; k < Dim; ++k)
+                r[k] = snapshot.m_r[k];
+
+            PositionsView view(r, snapshot.m_iteration, stamp, &snapshot.m_sequence, snapshot.m_publicationTime,
+                               snapshot.m_time, snapshot.m_timestep);
+
+            if (view.IsValid())
+                return view;
+        }
+    };
+
+    //*****************************************************************************************************
+    // publish_snapshot() - copy coordinates into the snapshot after the published one and publish it
+    //*****************************************************************************************************
+    // Called only by the thread which changes particles, readers never block it.
+    //*****************************************************************************************************
+    void publish_snapshot()
+    {
+        auto      begin    = std::chrono::steady_clock::now();
+        uint32_t  next     = (m_published.load(std::memory_order_relaxed) + 1) % m_snapshots.size();
+        Snapshot& snapshot = m_snapshots[next];
+        uint64_t  stamp    = 2 * ++m_publications;
+
+        snapshot.m_sequence.store(stamp - 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (size_t k = 0; k < Dim; ++k)
+        {
+            snapshot.m_r[k].resize(m_particles.size());
+
+            for (size_t i = 0; i < m_particles.size(); ++i)
+                snapshot.m_r[k][i] = m_particles[i].m_r[k];
+        }
+
+        snapshot.m_iteration       = uint32_t(m_iter);
+        snapshot.m_time            = m_time;
+        snapshot.m_timestep        = m_timestep;
+        snapshot.m_publicationTime = std::chrono::steady_clock::now();
+
+        snapshot.m_sequence.store(stamp, std::memory_order_release);
+        m_published.store(next, std::memory_order_release);
+
+        count(m_counters.m_publications, 1);
+        count(m_counters.m_publishTime, nanoseconds(snapshot.m_publicationTime - begin));
+    };
+
+    //*****************************************************************************************************
+    // GetPerformanceCounters() - read performance counters
+    //*****************************************************************************************************
+    // Counters are read one by one without a lock, so a reading taken during Process() may mix
+    // values of neighbouring iterations.
+    //*****************************************************************************************************
+    //! @return totals since the creation of the model
+    //*****************************************************************************************************
+    PerformanceCounters GetPerformanceCounters() const
+    {
+        PerformanceCounters c;
+
+        c.m_iterations      = m_counters.m_iterations.load(std::memory_order_relaxed);
+        c.m_particleSteps   = m_counters.m_particleSteps.load(std::memory_order_relaxed);
+        c.m_processTime     = m_counters.m_processTime.load(std::memory_order_relaxed);
+        c.m_pairEvaluations = m_counters.m_pairEvaluations.load(std::memory_order_relaxed);
+        c.m_lockWaits       = m_counters.m_lockWaits.load(std::memory_order_relaxed);
+        c.m_lockWaitTime    = m_counters.m_lockWaitTime.load(std::memory_order_relaxed);
+        c.m_publications    = m_counters.m_publications.load(std::memory_order_relaxed);
+        c.m_publishTime     = m_counters.m_publishTime.load(std::memory_order_relaxed);
+
+        return c;
+    };
 
-        std::vector<double> x(m_particles.size());
-        std::vector<double> y(m_particles.size());
+    //*****************************************************************************************************
+    // lock_data() - lock data of particles and count the time spent waiting for another thread
+    //*****************************************************************************************************
+    // An uncontended lock costs one try_lock, the clock is read only when the lock is busy.
+    //*****************************************************************************************************
+    //! @return owning lock of protection_mutex
+    //*****************************************************************************************************
+    std::unique_lock<std::mutex> lock_data()
+    {
+        std::unique_lock<std::mutex> lock(protection_mutex, std::try_to_lock);
 
-        for (auto i = 0; i < m_particles.size(); ++i)
+        if (!lock.owns_lock())
         {
-            x[i] = m_particles[i].m_x;
+            auto begin = std::chrono::steady_clock::now();
 
-            y[i] = m_particles[i].m_y;
+            lock.lock();
+
+            count(m_counters.m_lockWaits, 1);
+            count(m_counters.m_lockWaitTime, nanoseconds(std::chrono::steady_clock::now() - begin));
         }
 
-        return std::make_tuple(x,y);
+        return lock;
+    };
+
+    //*****************************************************************************************************
+    // count() - add to performance counter
+    //*****************************************************************************************************
+    //! @param [in] counter counter
+    //! @param [in] value added value
+    //*****************************************************************************************************
+    static void count(std::atomic<uint64_t>& counter, uint64_t value)
+    {
+        counter.fetch_add(value, std::memory_order_relaxed);
+    };
+
+    //*****************************************************************************************************
+    // nanoseconds() - convert duration of steady clock to ns
+    //*****************************************************************************************************
+    //! @param [in] duration duration
+    //! @return duration in ns
+    //*****************************************************************************************************
+    static uint64_t nanoseconds(std::chrono::steady_clock::duration duration)
+    {
+        return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+    };
+
+    //*****************************************************************************************************
+    // fill_positions() - copy coordinates of particles into buffers, the lock is held by the caller
+    //*****************************************************************************************************
+    //! @param [out] positions one buffer per axis
+    //*****************************************************************************************************
+    void fill_positions(const std::array<Span<double>, Dim>& positions)
+    {
+        for (size_t k = 0; k < Dim; ++k)
+        {
+            size_t count = std::min(positions[k].size(), m_particles.size());
+
+            for (size_t i = 0; i < count; ++i)
+                positions[k][i] = m_particles[i].m_r[k];
+        }
     };
 
     //*****************************************************************************************************
@@ -196,45 +697,195 @@ public:     // methods
     };
 
     //*****************************************************************************************************
-    // grid2d() - function which makes two dimensional grid
+    // grid3d() - function which makes three dimensional simple cubic grid
     //*****************************************************************************************************
     //! @param [in] i index of x axis coordinate for grid
     //! @param [in] j index of y axis coordinate for grid
+    //! @param [in] k index of z axis coordinate for grid
     //! @param [in] period period of grid
     //! @param [in] center_x value of x coordinate for center of grid
     //! @param [in] center_y value of y coordinate for center of grid
+    //! @param [in] center_z value of z coordinate for center of grid
     //! @return tuple with grid coordinates
     //*****************************************************************************************************
-    template<typename InputIt>
-    auto SetInitialVelocities(InputIt begin, InputIt end, double temperature)
+    auto grid3d(int i, int j, int k, double period, double center_x, double center_y, double center_z)
     {
-        size_t N = end - begin;
+        double x = center_x + i * period;
+        double y = center_y + j * period;
+        double z = center_z + k * period;
+
+        return std::make_tuple(x, y, z);
+    };
+
+    //*****************************************************************************************************
+    // fcc_cluster() - function which makes cubic block of face-centered cubic lattice
+    //*****************************************************************************************************
+    //! @param [in] cells number of cubic cells along every axis, 4 * cells^3 atoms
+    //! @param [in] period distance between nearest neighbours
+    //! @return coordinates of atoms centered at zero
+    //*****************************************************************************************************
+    auto fcc_cluster(int cells, double period)
+    {
+        static_assert(Dim == 3, "fcc lattice is three dimensional");
 
-        double V = sqrt(m_boltzman * temperature / Particle::m_m);
+        constexpr double basis[4][3] = { {0, 0, 0}, {0.5, 0.5, 0}, {0.5, 0, 0.5}, {0, 0.5, 0.5} };
 
-        std::uniform_real_distribution<> dist(0, 2 * 3.14159265358979323);
+        double a     = period * sqrt(2.);
+        double shift = (cells - 0.5) * a / 2;
 
-        double sumVx = 0;
-        double sumVy = 0;
+        std::vector<Vector> positions;
+        positions.reserve(4 * size_t(cells) * cells * cells);
 
-        for (auto i = begin; i != end; ++i)
+        for (int i = 0; i < cells; ++i)
+            for (int j = 0; j < cells; ++j)
+                for (int k = 0; k < cells; ++k)
+                    for (auto& b : basis)
+                        positions.push_back({ (i + b[0]) * a - shift, (j + b[1]) * a - shift, (k + b[2]) * a - shift });
+
+        return positions;
+    };
+
+    //*****************************************************************************************************
+    // icosahedral_cluster() - function which makes Mackay icosahedron
+    //*****************************************************************************************************
+    // Shell n consists of 12 vertices of icosahedron with edge n * period, n - 1 points on every edge
+    // and (n - 1)(n - 2) / 2 points inside every face, 10 n^2 + 2 atoms in total.
+    //*****************************************************************************************************
+    //! @param [in] shells number of shells around the central atom
+    //! @param [in] period distance between neighbours along the surface of shell
+    //! @return coordinates of atoms centered at zero
+    //*****************************************************************************************************
+    auto icosahedral_cluster(int shells, double period)
+    {
+        static_assert(Dim == 3, "icosahedron is three dimensional");
+
+        const double phi = (1 + sqrt(5.)) / 2;
+
+        // vertices of icosahedron with unit edge
+        std::vector<Vector> v;
+
+        for (double s1 : {-0.5, 0.5})
+        {
+            for (double s2 : {-0.5, 0.5})
+            {
+                v.push_back({ 0, s1, s2 * phi });
+                v.push_back({ s1, s2 * phi, 0 });
+                v.push_back({ s2 * phi, 0, s1 });
+            }
+        }
+
+        auto adjacent = [&](size_t a, size_t b)
+        {
+            Vector d;
+
+            for (size_t k = 0; k < 3; ++k)
+                d[k] = v[a][k] - v[b][k];
+
+            return std::abs(squared_norm(d) - 1) < 1E-6;
+        };
+
+        std::vector<std::pair<size_t, size_t>>          edges;
+        std::vector<std::tuple<size_t, size_t, size_t>> faces;
+
+        for (size_t a = 0; a < v.size(); ++a)
+        {
+            for (size_t b = a + 1; b < v.size(); ++b)
+            {
+                if (!adjacent(a, b))
+                    continue;
+
+                edges.emplace_back(a, b);
+
+                for (size_t c = b + 1; c < v.size(); ++c)
+                    if (adjacent(a, c) && adjacent(b, c))
+                        faces.emplace_back(a, b, c);
+            }
+        }
+
+        // point n * a + i * (b - a) + j * (c - a) of shell n
+        auto point = [&](size_t a, size_t b, size_t c, int n, int i, int j)
         {
-            double angle = dist(rd);
-            i->m_vX = V * cos(angle);
-            i->m_vY = V * sin(angle);
+            Vector p;
 
-            sumVx += i->m_vX;
-            sumVy += i->m_vY;
+            for (size_t k = 0; k < 3; ++k)
+                p[k] = period * (n * v[a][k] + i * (v[b][k] - v[a][k]) + j * (v[c][k] - v[a][k]));
+
+            return p;
+        };
+
+        std::vector<Vector> positions = { Vector{} };
+
+        for (int n = 1; n <= shells; ++n)
+        {
+            for (size_t a = 0; a < v.size(); ++a)
+                positions.push_back(point(a, a, a, n, 0, 0));
+
+            for (auto [a, b] : edges)
+                for (int i = 1; i < n; ++i)
+                    positions.push_back(point(a, b, b, n, i, 0));
+
+            for (auto [a, b, c] : faces)
+                for (int i = 1; i < n; ++i)
+                    for (int j = 1; i + j < n; ++j)
+                        positions.push_back(point(a, b, c, n, i, j));
         }
 
-        sumVx /= N;
-        sumVy /= N;
+        return positions;
+    };
+
+    //*****************************************************************************************************
+    // SetInitialVelocities() - set velocities of equal modul in random directions with zero total momentum
+    //*****************************************************************************************************
+    //! @param [in] begin begin iterator for particles vector
+    //! @param [in] end end iterator for particles vector
+    //! @param [in] temperature temperature in K
+    //*****************************************************************************************************
+    template<typename InputIt>
+    auto SetInitialVelocities(InputIt begin, InputIt end, double temperature)
+    {
+        size_t N = end - begin;
+
+        double V = sqrt(Dim / 2. * m_boltzman * temperature / ParticleType::m_m);
+
+        Vector sumV = {};
 
         for (auto i = begin; i != end; ++i)
         {
-            i->m_vX -= sumVx;
-            i->m_vY -= sumVy;
+            if constexpr (Dim == 2)
+            {
+                std::uniform_real_distribution<> dist(0, 2 * 3.14159265358979323);
+
+                double angle = dist(rd);
+                i->m_v[0] = V * cos(angle);
+                i->m_v[1] = V * sin(angle);
+            }
+            else
+            {
+                // normalized gaussian vector has uniform direction
+                std::normal_distribution<> dist;
+
+                Vector dir;
+
+                do
+                {
+                    for (size_t k = 0; k < Dim; ++k)
+                        dir[k] = dist(rd);
+                }
+                while (squared_norm(dir) == 0);
+
+                double scale = V / sqrt(squared_norm(dir));
+
+                for (size_t k = 0; k < Dim; ++k)
+                    i->m_v[k] = scale * dir[k];
+            }
+
+            for (size_t k = 0; k < Dim; ++k)
+                sumV[k] += i->m_v[k];
         }
+
+        for (auto i = begin; i != end; ++i)
+            for (size_t k = 0; k < Dim; ++k)
+                i->m_v[k] -= sumV[k] / N;
     }
 
     //*****************************************************************************************************
@@ -246,21 +897,27 @@ public:     // methods
     //*****************************************************************************************************
     void SetInitialConditions(int width, int height, double period)
     {
+        static_assert(Dim == 2, "planar grid needs two dimensional model");
+
         // height or width == 1 is problematic
         if ((width <= 1) || (height <= 1) || (period < 0))
             return;
 
         m_iter = 0;
+        m_time = 0;
+        m_respaReady = false;
+        m_stepHistory.clear();
+        ResetStatistics();
 
         // purely centered grid is not beautiful if side is even
         // double center_x = int(m_spaceRight - m_spaceLeft) / 2;
         // double center_y = int(m_spaceTop - m_spaceBot) / 2;
 
-        double center_x = (m_spaceRight - m_spaceLeft) / 2.;
-        double center_y = (m_spaceTop - m_spaceBot) / 2.;
+        double center_x = (m_spaceMax[0] - m_spaceMin[0]) / 2.;
+        double center_y = (m_spaceMax[1] - m_spaceMin[1]) / 2.;
 
-        m_particles.resize(width*height);
-        m_particles = std::vector<Particle>(width * height);
+        // capacity of the previous run is reused
+        m_particles.assign(width * height, ParticleType());
 
         int leftX  = - height / 2;
         int rightX = - leftX;
@@ -281,63 +938,206 @@ public:     // methods
         for (auto i = 0; i < size; ++i)
         {
             auto [x, y] = grid2d(leftX + i / width , leftY + i % width, period, center_x, center_y);
-            m_particles[i].m_x = x;
-            m_particles[i].m_y = y;
+            m_particles[i].m_r[0] = x;
+            m_particles[i].m_r[1] = y;
         }
 
         // temperature 1 Kelvin
         SetInitialVelocities(m_particles.begin(), m_particles.end(), m_temp);
 
         EvaluateTimeStep();
+        publish_snapshot();
     }
 
     //*****************************************************************************************************
-    // EvaluateTimeStep() - evaluate time step funtion
+    // SetInitialConditions() - function which set simple cubic grid as initial conditions
     //*****************************************************************************************************
-    //! @param [in, optional] factor value of factor of time step for adjustment
+    //! @param [in] width number of nodes along the y axis
+    //! @param [in] height number of nodes along the x axis
+    //! @param [in] depth number of nodes along the z axis
+    //! @param [in] period period of grid
     //*****************************************************************************************************
-    double EvaluateTimeStep(double factor = 0.01)
+    void SetInitialConditions(int width, int height, int depth, double period)
     {
-        if (factor <= 0)
-            factor = 0.01;
+        static_assert(Dim == 3, "spatial grid needs three dimensional model");
 
-        // time_step = factor * characteristic_time_for_the_model.
+        if ((width <= 1) || (height <= 1) || (depth <= 1) || (period < 0))
+            return;
 
-        // In that case characteristic time for the model will be period
-        // of particle oscillation in the quadratic approximation of Lennard-Jones potential well.
-        // T = (m * a ^ 2 / D) ^ (1 / 2) ~ 2 * 10 ^ (- 12)
-        m_timestep = factor * sqrt(Particle::m_m * m_equilibrium_distance * m_equilibrium_distance / m_depth);
+        int size = width * height * depth;
 
-        return m_timestep;
-    };
+        std::vector<Vector> positions(size);
+
+        for (auto i = 0; i < size; ++i)
+        {
+            auto [x, y, z] = grid3d(- height / 2 + i / (width * depth), - width / 2 + (i / depth) % width,
+                                    - depth / 2 + i % depth, period, 0, 0, 0);
+            positions[i] = { x, y, z };
+        }
+
+        SetPositions(positions);
+    }
 
     //*****************************************************************************************************
-    // particle_interaction() - function of particle interaction
+    // SetFccCluster() - set cubic block of fcc lattice as initial conditions
     //*****************************************************************************************************
-    //! @param [in] p1 link to first particle
-    //! @param [in] p2 link to second particle
-    //! @return tuple with potential, force_x for first particle, force_y for first particle
+    //! @param [in] cells number of cubic cells along every axis
+    //! @param [in] period distance between nearest neighbours
     //*****************************************************************************************************
-    inline static auto particle_interaction(Particle& p1, Particle& p2)
+    void SetFccCluster(int cells, double period)
     {
-        double dx = p2.m_x - p1.m_x;
-        double dy = p2.m_y - p1.m_y;
-
-        double r2  = dx * dx + dy * dy;
-        double ir6 = 1 / (r2 * r2 * r2);
-
-        double potential = 4  * m_depth * m_sigma6 * ir6 * (m_sigma6 * ir6 - 1);
-        double force1_x  = 24 * m_depth * m_sigma6 * ir6 * (- 2 * m_sigma6 * ir6 + 1) * dx / r2;
-        double force1_y  = 24 * m_depth * m_sigma6 * ir6 * (- 2 * m_sigma6 * ir6 + 1) * dy / r2;
+        if ((cells <= 0) || (period < 0))
+            return;
 
-        return std::make_tuple(potential, force1_x, force1_y);
-    };
+        SetPositions(fcc_cluster(cells, period));
+    }
 
     //*****************************************************************************************************
-    // integrate_position() - function of Verle algorithm for position of particle
+    // SetIcosahedralCluster() - set Mackay icosahedron as initial conditions
     //*****************************************************************************************************
-    //! @param [in] pos current value of particle position
-    //! @param [in] vel current value of particle velocity
+    //! @param [in] shells number of shells around the central atom
+    //! @param [in] period distance between neighbours along the surface of shell
+    //*****************************************************************************************************
+    void SetIcosahedralCluster(int shells, double period)
+    {
+        if ((shells <= 0) || (period < 0))
+            return;
+
+        SetPositions(icosahedral_cluster(shells, period));
+    }
+
+    //*****************************************************************************************************
+    // SetPositions() - set particles at given positions relative to the center of the modeling area
+    //*****************************************************************************************************
+    // Velocities are set for the init temperature and time step is evaluated with default factor.
+    //*****************************************************************************************************
+    //! @param [in] positions coordinates of particles relative to the center
+    //*****************************************************************************************************
+    void SetPositions(const std::vector<Vector>& positions)
+    {
+        m_iter = 0;
+        m_time = 0;
+        m_respaReady = false;
+        m_stepHistory.clear();
+        ResetStatistics();
+
+        m_particles.assign(positions.size(), ParticleType());
+
+        for (size_t i = 0; i < positions.size(); ++i)
+            for (size_t k = 0; k < Dim; ++k)
+                m_particles[i].m_r[k] = (m_spaceMax[k] - m_spaceMin[k]) / 2. + positions[i][k];
+
+        SetInitialVelocities(m_particles.begin(), m_particles.end(), m_temp);
+
+        EvaluateTimeStep();
+        publish_snapshot();
+    }
+
+    //*****************************************************************************************************
+    // EvaluateTimeStep() - evaluate time step funtion
+    //*****************************************************************************************************
+    //! @param [in, optional] factor value of factor of time step for adjustment
+    //*****************************************************************************************************
+    double EvaluateTimeStep(double factor = 0.01)
+    {
+        if (factor <= 0)
+            factor = 0.01;
+
+        // time_step = factor * characteristic_time_for_the_model.
+
+        // In that case characteristic time for the model will be period
+        // of particle oscillation in the quadratic approximation of Lennard-Jones potential well.
+        // T = (m * a ^ 2 / D) ^ (1 / 2) ~ 2 * 10 ^ (- 12)
+        m_timestep = factor * characteristic_time();
+
+        return m_timestep;
+    };
+
+    //*****************************************************************************************************
+    // characteristic_time() - period of oscillation in the quadratic approximation of the potential well
+    //*****************************************************************************************************
+    //! @return characteristic time in s
+    //*****************************************************************************************************
+    static double characteristic_time()
+    {
+        return sqrt(ParticleType::m_m * m_equilibrium_distance * m_equilibrium_distance / m_depth);
+    };
+
+    //*****************************************************************************************************
+    // filled() - vector with equal components
+    //*****************************************************************************************************
+    //! @param [in] value value of every component
+    //! @return vector
+    //*****************************************************************************************************
+    static Vector filled(double value)
+    {
+        Vector v;
+        v.fill(value);
+
+        return v;
+    };
+
+    //*****************************************************************************************************
+    // minimum_image() - fold distance into the nearest periodic image
+    //*****************************************************************************************************
+    // Works without branches and vectorizes: with zero inverse period the distance is returned as is.
+    //*****************************************************************************************************
+    //! @param [in] d distance along one axis
+    //! @param [in] period period along the axis
+    //! @param [in] inv_period inverse period along the axis or 0 if the axis is not periodic
+    //! @return distance to the nearest image
+    //*****************************************************************************************************
+    inline static double minimum_image(double d, double period, double inv_period)
+    {
+        return d - period * static_cast<int32_t>(d * inv_period + std::copysign(0.5, d));
+    };
+
+    //*****************************************************************************************************
+    // pair_vector() - vector from first to second particle with minimum image convention
+    //*****************************************************************************************************
+    //! @param [in] p1 link to first particle
+    //! @param [in] p2 link to second particle
+    //! @return vector p2 - p1
+    //*****************************************************************************************************
+    inline Vector pair_vector(const ParticleType& p1, const ParticleType& p2) const
+    {
+        Vector d;
+
+        for (size_t k = 0; k < Dim; ++k)
+            d[k] = minimum_image(p2.m_r[k] - p1.m_r[k], m_period[k], m_invPeriod[k]);
+
+        return d;
+    };
+
+    //*****************************************************************************************************
+    // particle_interaction() - function of particle interaction
+    //*****************************************************************************************************
+    //! @param [in] p1 link to first particle
+    //! @param [in] p2 link to second particle
+    //! @return tuple with potential and force for first particle
+    //*****************************************************************************************************
+    inline auto particle_interaction(ParticleType& p1, ParticleType& p2) const
+    {
+        Vector d = pair_vector(p1, p2);
+
+        double r2  = squared_norm(d);
+        double ir6 = 1 / (r2 * r2 * r2);
+
+        double potential = 4  * m_depth * m_sigma6 * ir6 * (m_sigma6 * ir6 - 1);
+
+        Vector force1;
+
+        for (size_t k = 0; k < Dim; ++k)
+            force1[k] = 24 * m_depth * m_sigma6 * ir6 * (- 2 * m_sigma6 * ir6 + 1) * d[k] / r2;
+
+        return std::make_tuple(potential, force1);
+    };
+
+    //*****************************************************************************************************
+    // integrate_position() - function of Verle algorithm for position of particle
+    //*****************************************************************************************************
+    //! @param [in] pos current value of particle position
+    //! @param [in] vel current value of particle velocity
     //! @param [in] acc current value of particle acceleration
     //! @param [in] dt value time step for modeling
     //! @return new value of particle position
@@ -378,6 +1178,295 @@ public:     // methods
     //    if ((dx > m_spaceWidthHalf) || (dy > m_spaceWidth))
     //};
 
+    //*****************************************************************************************************
+    // lennard_jones() - Lennard-Jones force factor for squared distance between particles
+    //*****************************************************************************************************
+    //! @param [in] r2 squared distance between particles
+    //! @param [out] potential potential energy of the pair
+    //! @return factor which gives force on the first particle when multiplied by (p2 - p1)
+    //*****************************************************************************************************
+    inline static double lennard_jones(double r2, double& potential)
+    {
+        double ir2 = 1 / r2;
+        double s6  = m_sigma6 * ir2 * ir2 * ir2;
+
+        potential = 4  * m_depth * s6 * (s6 - 1);
+
+        return      24 * m_depth * s6 * (- 2 * s6 + 1) * ir2;
+    };
+
+    //*****************************************************************************************************
+    // pairwise_forces() - straightforward all-pairs force loop
+    //*****************************************************************************************************
+    //! @param [in] begin begin iterator for particles vector
+    //! @param [in] end end iterator for particles vector
+    //! @param [in] particle_interaction link to function of interaction between 2 particles
+    //! @return potential energy of the system
+    //*****************************************************************************************************
+    template <typename InputIt, typename InteractionFunc>
+    double pairwise_forces(InputIt begin, InputIt end, InteractionFunc particle_interaction)
+    {
+        double   potential_energy = 0;
+        uint64_t size             = end - begin;
+
+        count(m_counters.m_pairEvaluations, size * (size - 1) / 2);
+
+        for (auto i = begin; i != end - 1; ++i)
+        {
+            for (auto j = i + 1; j != end; ++j)
+            {
+                auto [pot, force1] = particle_interaction(*i, *j);
+
+                for (size_t k = 0; k < Dim; ++k)
+                {
+                    i->m_a[k] += force1[k];
+                    j->m_a[k] -= force1[k];
+                }
+
+                potential_energy += pot;
+            }
+        }
+
+        return potential_energy;
+    };
+
+    //*****************************************************************************************************
+    // tiled_forces() - cache-blocked all-pairs force loop for small clusters
+    //*****************************************************************************************************
+    // Positions are gathered into contiguous arrays, then every block of m_tileSize particles
+    // is processed against all following blocks. Forces of the j-block are accumulated in a local
+    // tile and written back once, so the inner loop has no dependency between iterations.
+    //*****************************************************************************************************
+    //! @param [in] begin begin iterator for particles vector
+    //! @param [in] end end iterator for particles vector
+    //! @return potential energy of the system
+    //*****************************************************************************************************
+    template <typename InputIt>
+    double tiled_forces(InputIt begin, InputIt end)
+    {
+        size_t size = end - begin;
+
+        count(m_counters.m_pairEvaluations, uint64_t(size) * (size - 1) / 2);
+
+        for (size_t k = 0; k < Dim; ++k)
+        {
+            m_tileR[k].resize(size);
+            m_tileF[k].assign(size, 0.0);
+
+            for (size_t i = 0; i < size; ++i)
+                m_tileR[k][i] = begin[i].m_r[k];
+        }
+
+        double period[Dim], inv_period[Dim];
+
+        for (size_t k = 0; k < Dim; ++k)
+        {
+            period[k]     = m_period[k];
+            inv_period[k] = m_invPeriod[k];
+        }
+
+        double potential_energy = 0;
+
+        for (size_t ib = 0; ib < size; ib += m_tileSize)
+        {
+            size_t ni = std::min(m_tileSize, size - ib);
+
+            double ri[Dim][m_tileSize];
+            double fi[Dim][m_tileSize] = {};
+
+            for (size_t k = 0; k < Dim; ++k)
+                for (size_t i = 0; i < ni; ++i)
+                    ri[k][i] = m_tileR[k][ib + i];
+
+            // pairs inside the block
+            for (size_t i = 0; i < ni; ++i)
+            {
+                for (size_t j = i + 1; j < ni; ++j)
+                {
+                    double d[Dim];
+                    double r2 = 0;
+
+                    for (size_t k = 0; k < Dim; ++k)
+                    {
+                        d[k] = minimum_image(ri[k][j] - ri[k][i], period[k], inv_period[k]);
+                        r2  += d[k] * d[k];
+                    }
+
+                    double pot;
+                    double f = lennard_jones(r2, pot);
+
+                    for (size_t k = 0; k < Dim; ++k)
+                    {
+                        fi[k][i] += f * d[k];
+                        fi[k][j] -= f * d[k];
+                    }
+
+                    potential_energy += pot;
+                }
+            }
+
+            // pairs between the block and the following blocks
+            for (size_t jb = ib + m_tileSize; jb < size; jb += m_tileSize)
+            {
+                size_t nj = std::min(m_tileSize, size - jb);
+
+                const double* rj[Dim];
+                double fj[Dim][m_tileSize] = {};
+
+                for (size_t k = 0; k < Dim; ++k)
+                    rj[k] = &m_tileR[k][jb];
+
+                for (size_t i = 0; i < ni; ++i)
+                {
+                    // row of pair forces is stored, not summed, so that the loop has no reductions
+                    double row_f[Dim][m_tileSize], row_pot[m_tileSize];
+
+                    for (size_t j = 0; j < nj; ++j)
+                    {
+                        double d[Dim];
+                        double r2 = 0;
+
+                        for (size_t k = 0; k < Dim; ++k)
+                        {
+                            d[k] = minimum_image(rj[k][j] - ri[k][i], period[k], inv_period[k]);
+                            r2  += d[k] * d[k];
+                        }
+
+                        double f = lennard_jones(r2, row_pot[j]);
+
+                        for (size_t k = 0; k < Dim; ++k)
+                        {
+                            row_f[k][j] = f * d[k];
+                            fj[k][j]   -= row_f[k][j];
+                        }
+                    }
+
+                    for (size_t j = 0; j < nj; ++j)
+                    {
+                        for (size_t k = 0; k < Dim; ++k)
+                            fi[k][i] += row_f[k][j];
+
+                        potential_energy += row_pot[j];
+                    }
+                }
+
+                for (size_t k = 0; k < Dim; ++k)
+                    for (size_t j = 0; j < nj; ++j)
+                        m_tileF[k][jb + j] += fj[k][j];
+            }
+
+            for (size_t k = 0; k < Dim; ++k)
+                for (size_t i = 0; i < ni; ++i)
+                    m_tileF[k][ib + i] += fi[k][i];
+        }
+
+        for (size_t i = 0; i < size; ++i)
+            for (size_t k = 0; k < Dim; ++k)
+                begin[i].m_a[k] += m_tileF[k][i];
+
+        return potential_energy;
+    };
+
+    //*****************************************************************************************************
+    // SetTiledThreshold() - set max number of particles for which the tiled kernel is used
+    //*****************************************************************************************************
+    //! @param [in] n number of particles, 0 disables the tiled kernel
+    //*****************************************************************************************************
+    void SetTiledThreshold(size_t n)
+    {
+        m_tiledThreshold = n;
+    };
+
+    //*****************************************************************************************************
+    // apply_boundaries() - wrap or reflect particles which crossed the walls
+    //*****************************************************************************************************
+    //! @param [in] begin begin iterator for particles vector
+    //! @param [in] end end iterator for particles vector
+    //*****************************************************************************************************
+    template <typename InputIt>
+    void apply_boundaries(InputIt begin, InputIt end)
+    {
+        if (m_boundary == Boundary::Periodic)
+        {
+            for (auto i = begin; i != end; ++i)
+                for (size_t k = 0; k < Dim; ++k)
+                    i->m_r[k] -= m_period[k] * std::floor((i->m_r[k] - m_spaceMin[k]) * m_invPeriod[k]);
+        }
+        else if (m_boundary == Boundary::Reflecting)
+        {
+            for (auto i = begin; i != end; ++i)
+            {
+                for (size_t k = 0; k < Dim; ++k)
+                {
+                    if ((i->m_r[k] < m_spaceMin[k]) || (i->m_r[k] > m_spaceMax[k]))
+                    {
+                        i->m_r[k] = (i->m_r[k] < m_spaceMin[k]) ? 2 * m_spaceMin[k] - i->m_r[k] : 2 * m_spaceMax[k] - i->m_r[k];
+                        i->m_v[k] = - i->m_v[k];
+                    }
+                }
+            }
+        }
+    };
+
+    //*****************************************************************************************************
+    // SetBoundaries() - set type of boundaries of the modeling area
+    //*****************************************************************************************************
+    //! @param [in] boundary type of boundaries
+    //*****************************************************************************************************
+    void SetBoundaries(Boundary boundary)
+    {
+        m_boundary = boundary;
+
+        for (size_t k = 0; k < Dim; ++k)
+        {
+            m_period[k]    = m_spaceMax[k] - m_spaceMin[k];
+            m_invPeriod[k] = (boundary == Boundary::Periodic) ? 1 / m_period[k] : 0;
+        }
+
+        m_respaReady = false;
+
+        auto lock = lock_data();
+
+        apply_boundaries(m_particles.begin(), m_particles.end());
+    };
+
+    //*****************************************************************************************************
+    // SetModelingSpace() - set size of the modeling area
+    //*****************************************************************************************************
+    //! @param [in] sizes width, height (and depth) of the area in m
+    //*****************************************************************************************************
+    template <typename... Sizes>
+    void SetModelingSpace(Sizes... sizes)
+    {
+        static_assert(sizeof...(Sizes) == Dim, "one size per axis is expected");
+
+        Vector size = { double(sizes)... };
+
+        for (size_t k = 0; k < Dim; ++k)
+            if (size[k] <= 0)
+                return;
+
+        m_spaceMin = {};
+        m_spaceMax = size;
+
+        SetBoundaries(m_boundary);
+    };
+
+    //*****************************************************************************************************
+    // GetModelingSpace() - get size of the modeling area
+    //*****************************************************************************************************
+    //! @return width, height (and depth) of the area in m
+    //*****************************************************************************************************
+    Vector GetModelingSpace()
+    {
+        Vector size;
+
+        for (size_t k = 0; k < Dim; ++k)
+            size[k] = m_spaceMax[k] - m_spaceMin[k];
+
+        return size;
+    };
+
     //*****************************************************************************************************
     // velocity_verlet_process() - function of Verle algorithm
     //*****************************************************************************************************
@@ -392,64 +1481,470 @@ public:     // methods
         // swap a_i with a_i+1
         for (auto i = begin; i != end; ++i)
         {
-            i->m_aX_previous = i->m_aX;
-            i->m_aX = 0.0;
-            i->m_aY_previous = i->m_aY;
-            i->m_aY = 0.0;
+            i->m_a_previous = i->m_a;
+            i->m_a.fill(0.0);
         }
 
         // defines lock`s scope
         {
-           std::lock_guard<std::mutex> lock(protection_mutex);
+           auto lock = lock_data();
 
            // update positions values
            for (auto i = begin; i != end; ++i)
-           {
-               i->m_x = integrate_position(i->m_x, i->m_vX, i->m_aX_previous, m_timestep);
-               i->m_y = integrate_position(i->m_y, i->m_vY, i->m_aY_previous, m_timestep);
-           }
+               for (size_t k = 0; k < Dim; ++k)
+                   i->m_r[k] = integrate_position(i->m_r[k], i->m_v[k], i->m_a_previous[k], m_timestep);
+
+           apply_boundaries(begin, end);
         }
 
-        double potential_energy = 0;    // Potential energy for all system
+        // Find new accelerations, small clusters go through the tiled kernel
+        double potential_energy = (size_t(end - begin) <= m_tiledThreshold)
+                                ? tiled_forces(begin, end)
+                                : pairwise_forces(begin, end, particle_interaction);
 
-        // Find new accelerations
-        for (auto i = begin; i != end - 1; ++i)
+        m_pE     = potential_energy;
+        m_pESum += potential_energy;
+
+        for (auto i = begin; i != end; ++i)
+            for (size_t k = 0; k < Dim; ++k)
+                i->m_a[k] /= ParticleType::m_m;
+
+        double kinetic_energy = 0;
+        double max_v2         = 0;
+        double max_a2         = 0;
+
+        for (auto i = begin; i != end; ++i)
         {
-            for (auto j = i + 1; j != end; ++j)
+            for (size_t k = 0; k < Dim; ++k)
+                i->m_v[k] = integrate_velocity(i->m_v[k], i->m_a[k], i->m_a_previous[k], m_timestep);
+
+            i->AddVelocityInSum();
+
+            double v2 = squared_norm(i->m_v);
+
+            kinetic_energy += i->m_m * v2 / 2.;
+            max_v2          = std::max(max_v2, v2);
+            max_a2          = std::max(max_a2, squared_norm(i->m_a));
+        }
+
+        m_kE     = kinetic_energy;
+        m_kESum += kinetic_energy;
+        m_maxV2  = std::max(m_maxV2, max_v2);
+        m_maxA2  = std::max(m_maxA2, max_a2);
+    }
+
+    //*****************************************************************************************************
+    // respa_switch() - smooth switch between fast and slow parts of the force
+    //*****************************************************************************************************
+    //! @param [in] r distance between particles
+    //! @param [out] dswitch derivative of the switch over r
+    //! @return share of the potential treated as fast, 1 below m_respaInner and 0 above m_respaOuter
+    //*****************************************************************************************************
+    double respa_switch(double r, double& dswitch) const
+    {
+        double width = m_respaOuter - m_respaInner;
+        double t     = std::clamp((r - m_respaInner) / width, 0.0, 1.0);
+
+        dswitch = 6 * t * (t - 1) / width;
+
+        return 1 - t * t * (3 - 2 * t);
+    };
+
+    //*****************************************************************************************************
+    // respa_split_forces() - evaluate fast and slow accelerations of all particles
+    //*****************************************************************************************************
+    // Also rebuilds the list of pairs which can feel the fast force until the next outer step.
+    //*****************************************************************************************************
+    //! @param [in] begin begin iterator for particles vector
+    //! @param [in] end end iterator for particles vector
+    //! @return potential energy of the system
+    //*****************************************************************************************************
+    template <typename InputIt>
+    double respa_split_forces(InputIt begin, InputIt end)
+    {
+        uint32_t size    = end - begin;
+        double   list_r2 = (m_respaOuter + m_respaSkin) * (m_respaOuter + m_respaSkin);
+
+        for (auto i = begin; i != end; ++i)
+            i->m_a.fill(0.0);
+
+        double potential_energy = (size <= m_tiledThreshold)
+                                ? tiled_forces(begin, end)
+                                : pairwise_forces(begin, end, [this](ParticleType& p1, ParticleType& p2)
+                                                  { return particle_interaction(p1, p2); });
+
+        m_respaPairs.clear();
+
+        for (uint32_t i = 0; i + 1 < size; ++i)
+            for (uint32_t j = i + 1; j < size; ++j)
+                if (squared_norm(pair_vector(begin[i], begin[j])) < list_r2)
+                    m_respaPairs.emplace_back(i, j);
+
+        for (size_t k = 0; k < Dim; ++k)
+        {
+            m_fastA[k].resize(size);
+            m_slowA[k].resize(size);
+        }
+
+        respa_fast_forces(begin);
+
+        for (uint32_t i = 0; i < size; ++i)
+        {
+            for (size_t k = 0; k < Dim; ++k)
+            {
+                begin[i].m_a[k] /= ParticleType::m_m;
+
+                m_slowA[k][i] = begin[i].m_a[k] - m_fastA[k][i];
+            }
+        }
+
+        m_respaReady = true;
+
+        return potential_energy;
+    };
+
+    //*****************************************************************************************************
+    // respa_fast_forces() - evaluate fast accelerations over the list of close pairs
+    //*****************************************************************************************************
+    //! @param [in] begin begin iterator for particles vector, pairs index particles from it
+    //*****************************************************************************************************
+    template <typename InputIt>
+    void respa_fast_forces(InputIt begin)
+    {
+        for (size_t k = 0; k < Dim; ++k)
+            std::fill(m_fastA[k].begin(), m_fastA[k].end(), 0.0);
+
+        count(m_counters.m_pairEvaluations, m_respaPairs.size());
+
+        for (auto [i, j] : m_respaPairs)
+        {
+            Vector d  = pair_vector(begin[i], begin[j]);
+            double r2 = squared_norm(d);
+            double pot;
+            double fast_f = lennard_jones(r2, pot);
+
+            if (r2 > m_respaInner * m_respaInner)
             {
-                auto [pot, force_x1, force_y1] = particle_interaction(*i, *j);
+                double r = sqrt(r2);
+                double dswitch;
+                double sw = respa_switch(r, dswitch);
 
-                i->m_aX += force_x1;
-                i->m_aY += force_y1;
-                j->m_aX -= force_x1;
-                j->m_aY -= force_y1;
+                fast_f = sw * fast_f + dswitch * pot / r;
+            }
 
-                potential_energy += pot;
+            for (size_t k = 0; k < Dim; ++k)
+            {
+                m_fastA[k][i] += fast_f * d[k];
+                m_fastA[k][j] -= fast_f * d[k];
             }
         }
 
-        m_pESum += potential_energy;
+        for (size_t k = 0; k < Dim; ++k)
+            for (size_t i = 0; i < m_fastA[k].size(); ++i)
+                m_fastA[k][i] /= ParticleType::m_m;
+    };
+
+    //*****************************************************************************************************
+    // respa_process() - one outer step of the multiple time step (RESPA) integrator
+    //*****************************************************************************************************
+    // Slow forces kick velocities for half of m_timestep at both ends of the outer step, in between
+    // m_respaSteps velocity Verlet steps of m_timestep / m_respaSteps are made with fast forces only.
+    // The fast forces are evaluated over the pair list, so the inner steps cost
+    // is set by the close pairs, not by all pairs of the system.
+    //*****************************************************************************************************
+    //! @param [in] begin begin iterator for particles vector
+    //! @param [in] end end iterator for particles vector
+    //*****************************************************************************************************
+    template <typename InputIt>
+    void respa_process(InputIt begin, InputIt end)
+    {
+        size_t size  = end - begin;
+        double outer = m_timestep;
+        double inner = m_timestep / m_respaSteps;
+
+        if (!m_respaReady || (m_fastA[0].size() != size))
+            respa_split_forces(begin, end);
+
+        for (size_t i = 0; i < size; ++i)
+        {
+            begin[i].m_a_previous = begin[i].m_a;
+
+            for (size_t k = 0; k < Dim; ++k)
+                begin[i].m_v[k] += outer * m_slowA[k][i] / 2.;
+        }
 
+        for (uint32_t s = 0; s < m_respaSteps; ++s)
+        {
+            {
+                auto lock = lock_data();
+
+                for (size_t i = 0; i < size; ++i)
+                {
+                    for (size_t k = 0; k < Dim; ++k)
+                    {
+                        begin[i].m_v[k] += inner * m_fastA[k][i] / 2.;
+                        begin[i].m_r[k] += inner * begin[i].m_v[k];
+                    }
+                }
+
+                apply_boundaries(begin, end);
+            }
+
+            if (s + 1 < m_respaSteps)
+                respa_fast_forces(begin);
+            else
+            {
+                m_pE     = respa_split_forces(begin, end);
+                m_pESum += m_pE;
+            }
+
+            for (size_t i = 0; i < size; ++i)
+                for (size_t k = 0; k < Dim; ++k)
+                    begin[i].m_v[k] += inner * m_fastA[k][i] / 2.;
+        }
+
+        double kinetic_energy = 0;
+        double max_v2         = 0;
+        double max_a2         = 0;
+
+        for (size_t i = 0; i < size; ++i)
+        {
+            for (size_t k = 0; k < Dim; ++k)
+                begin[i].m_v[k] += outer * m_slowA[k][i] / 2.;
+
+            begin[i].AddVelocityInSum();
+
+            double v2 = squared_norm(begin[i].m_v);
+
+            kinetic_energy += ParticleType::m_m * v2 / 2.;
+            max_v2          = std::max(max_v2, v2);
+            max_a2          = std::max(max_a2, squared_norm(begin[i].m_a));
+        }
+
+        m_kE     = kinetic_energy;
+        m_kESum += kinetic_energy;
+        m_maxV2  = std::max(m_maxV2, max_v2);
+        m_maxA2  = std::max(m_maxA2, max_a2);
+    };
+
+    //*****************************************************************************************************
+    // SetIntegrator() - choose time integration scheme
+    //*****************************************************************************************************
+    // With Integrator::Respa m_timestep is the outer step, so EvaluateTimeStep() factor
+    // may be about innerSteps times larger than with velocity Verlet.
+    //*****************************************************************************************************
+    //! @param [in] integrator integration scheme
+    //! @param [in, optional] innerSteps number of inner RESPA steps per outer step
+    //*****************************************************************************************************
+    void SetIntegrator(Integrator integrator, uint32_t innerSteps = 4)
+    {
+        m_integrator  = integrator;
+        m_respaSteps  = std::max<uint32_t>(innerSteps, 1);
+        m_respaReady  = false;
+    };
+
+    //*****************************************************************************************************
+    // SetRespaSwitch() - set distances where LJ force is split into fast and slow parts
+    //*****************************************************************************************************
+    //! @param [in] inner distance in sigma below which the whole force is fast
+    //! @param [in] outer distance in sigma beyond which the whole force is slow
+    //*****************************************************************************************************
+    void SetRespaSwitch(double inner, double outer)
+    {
+        if ((inner <= 0) || (outer <= inner))
+            return;
+
+        m_respaInner = inner * m_sigma;
+        m_respaOuter = outer * m_sigma;
+        m_respaReady = false;
+    };
+
+    //*****************************************************************************************************
+    // scale_velocities() - multiply all velocities and the last kinetic energy by a factor
+    //*****************************************************************************************************
+    //! @param [in] begin begin iterator for particles vector
+    //! @param [in] end end iterator for particles vector
+    //! @param [in] scale factor of velocities
+    //*****************************************************************************************************
+    template <typename InputIt>
+    void scale_velocities(InputIt begin, InputIt end, double scale)
+    {
         for (auto i = begin; i != end; ++i)
+            for (size_t k = 0; k < Dim; ++k)
+                i->m_v[k] *= scale;
+
+        m_kESum += (scale * scale - 1) * m_kE;
+        m_kE    *= scale * scale;
+    };
+
+    //*****************************************************************************************************
+    // apply_thermostat() - apply thermostat after one iteration
+    //*****************************************************************************************************
+    //! @param [in] begin begin iterator for particles vector
+    //! @param [in] end end iterator for particles vector
+    //*****************************************************************************************************
+    template <typename InputIt>
+    void apply_thermostat(InputIt begin, InputIt end)
+    {
+        size_t size = end - begin;
+        double dof  = double(Dim) * size;
+
+        if ((size == 0) || (m_thermostatTime <= 0))
+            return;
+
+        switch (m_thermostat)
         {
-            i->m_aX /= Particle::m_m;
-            i->m_aY /= Particle::m_m;
+        case Thermostat::Berendsen:
+        {
+            double t = 2 * m_kE / (dof * m_boltzman);
+
+            if (t > 0)
+                scale_velocities(begin, end, sqrt(std::max(0.0, 1 + m_timestep / m_thermostatTime * (m_thermostatTemp / t - 1))));
+
+            break;
+        }
+        case Thermostat::Langevin:
+        {
+            double c1 = exp(- m_timestep / m_thermostatTime);
+            double c2 = sqrt((1 - c1 * c1) * m_boltzman * m_thermostatTemp / ParticleType::m_m);
+
+            m_noise.resize(Dim * size);
+            m_normal.Fill(m_noise.data(), m_noise.size());
+
+            double kinetic_energy = 0;
+
+            for (size_t i = 0; i < size; ++i)
+            {
+                for (size_t k = 0; k < Dim; ++k)
+                    begin[i].m_v[k] = c1 * begin[i].m_v[k] + c2 * m_noise[Dim * i + k];
+
+                kinetic_energy += ParticleType::m_m * squared_norm(begin[i].m_v) / 2.;
+            }
+
+            m_kESum += kinetic_energy - m_kE;
+            m_kE     = kinetic_energy;
+
+            break;
         }
+        case Thermostat::NoseHoover:
+            nose_hoover_half_step(begin, end);
+            break;
+        default:
+            break;
+        }
+    };
+
+    //*****************************************************************************************************
+    // nose_hoover_half_step() - propagate Nose-Hoover chain for half of the time step
+    //*****************************************************************************************************
+    // Martyna-Tuckerman-Klein scheme, called before and after every iteration.
+    //*****************************************************************************************************
+    //! @param [in] begin begin iterator for particles vector
+    //! @param [in] end end iterator for particles vector
+    //*****************************************************************************************************
+    template <typename InputIt>
+    void nose_hoover_half_step(InputIt begin, InputIt end)
+    {
+        size_t size   = end - begin;
+        size_t length = m_chainQ.size();
+        double dof    = double(Dim) * size;
+        double kT     = m_boltzman * m_thermostatTemp;
+
+        if ((size == 0) || (length == 0))
+            return;
 
+        // kinetic energy is kept only for the last iteration, so it is recalculated here
         double kinetic_energy = 0;
 
         for (auto i = begin; i != end; ++i)
+            kinetic_energy += ParticleType::m_m * squared_norm(i->m_v) / 2.;
+
+        m_kE = kinetic_energy;
+
+        // particles may be set after the thermostat
+        m_chainQ[0] = dof * kT * m_thermostatTime * m_thermostatTime;
+
+        double dt2 = m_timestep / 2;
+        double dt4 = m_timestep / 4;
+        double dt8 = m_timestep / 8;
+
+        auto& g = m_chainG;
+
+        g[0] = (2 * kinetic_energy - dof * kT) / m_chainQ[0];
+
+        for (size_t j = 1; j < length; ++j)
+            g[j] = (m_chainQ[j - 1] * m_chainVXi[j - 1] * m_chainVXi[j - 1] - kT) / m_chainQ[j];
+
+        m_chainVXi[length - 1] += g[length - 1] * dt4;
+
+        for (size_t j = length - 1; j-- > 0;)
         {
-            i->m_vX = integrate_velocity(i->m_vX, i->m_aX, i->m_aX_previous, m_timestep);
-            i->m_vY = integrate_velocity(i->m_vY, i->m_aY, i->m_aY_previous, m_timestep);
+            double aa = exp(- dt8 * m_chainVXi[j + 1]);
+            m_chainVXi[j] = m_chainVXi[j] * aa * aa + dt4 * g[j] * aa;
+        }
 
-            i->AddVelocityInSum();
+        double scale = exp(- dt2 * m_chainVXi[0]);
+
+        for (size_t j = 0; j < length; ++j)
+            m_chainXi[j] += dt2 * m_chainVXi[j];
+
+        g[0] = (2 * kinetic_energy * scale * scale - dof * kT) / m_chainQ[0];
 
-            kinetic_energy += i->m_m * (i->m_vX * i->m_vX + i->m_vY * i->m_vY) / 2.;
+        for (size_t j = 0; j + 1 < length; ++j)
+        {
+            double aa = exp(- dt8 * m_chainVXi[j + 1]);
+            m_chainVXi[j] = m_chainVXi[j] * aa * aa + dt4 * g[j] * aa;
+            g[j + 1] = (m_chainQ[j] * m_chainVXi[j] * m_chainVXi[j] - kT) / m_chainQ[j + 1];
         }
 
-        m_kESum += kinetic_energy;
-    }
+        m_chainVXi[length - 1] += g[length - 1] * dt4;
+
+        scale_velocities(begin, end, scale);
+    };
+
+    //*****************************************************************************************************
+    // SetThermostat() - enable thermostat, f.e. for equilibration before a microcanonical run
+    //*****************************************************************************************************
+    //! @param [in] thermostat type of thermostat, Thermostat::None disables it
+    //! @param [in] temperature target temperature in K
+    //! @param [in, optional] couplingTime relaxation time in s, 0 means half of characteristic time
+    //! @param [in, optional] chainLength number of thermostats in Nose-Hoover chain
+    //*****************************************************************************************************
+    void SetThermostat(Thermostat thermostat, double temperature, double couplingTime = 0, uint32_t chainLength = 3)
+    {
+        if ((temperature < 0) || ((thermostat == Thermostat::NoseHoover) && (temperature == 0)))
+            return;
+
+        m_thermostat     = thermostat;
+        m_thermostatTemp = temperature;
+        m_thermostatTime = (couplingTime > 0) ? couplingTime : characteristic_time() / 2;
+
+        m_chainXi.clear();
+        m_chainVXi.clear();
+        m_chainQ.clear();
+
+        if (thermostat == Thermostat::NoseHoover)
+        {
+            double kT = m_boltzman * temperature;
+            double t2 = m_thermostatTime * m_thermostatTime;
+
+            chainLength = std::max<uint32_t>(chainLength, 1);
+
+            m_chainXi.assign(chainLength, 0.0);
+            m_chainVXi.assign(chainLength, 0.0);
+            // mass of the first thermostat depends on the number of particles, it is set by every step
+            m_chainQ.assign(chainLength, kT * t2);
+            m_chainG.assign(chainLength, 0.0);
+        }
+    };
+
+    //*****************************************************************************************************
+    // DisableThermostat() - switch back to microcanonical run
+    //*****************************************************************************************************
+    void DisableThermostat()
+    {
+        SetThermostat(Thermostat::None, m_thermostatTemp);
+    };
 
     //*****************************************************************************************************
     // Process() - process some iterations of modeling function
@@ -458,21 +1953,195 @@ public:     // methods
     //*****************************************************************************************************
     void Process(uint32_t iterations)
     {
-        for (uint32_t i = 0; i < iterations; ++i)
-            Process();
+        auto begin = std::chrono::steady_clock::now();
+
+        if (!m_adaptiveStep)
+        {
+            for (uint32_t i = 0; i < iterations; ++i)
+                Process();
+        }
+
+        while (m_adaptiveStep && (iterations > 0))
+        {
+            // energy of the current state is known only after the first step, it is one of the iterations
+            if (m_iter == 0)
+            {
+                Process();
+
+                if (--iterations == 0)
+                    break;
+            }
+
+            uint32_t block = std::min(iterations, m_adaptiveBlock);
+
+            double energy = m_kE + m_pE;
+
+            m_maxV2 = 0;
+            m_maxA2 = 0;
 
-        return;
+            for (uint32_t i = 0; i < block; ++i)
+                Process();
+
+            AdaptTimeStep(m_kE + m_pE - energy);
+
+            iterations -= block;
+        }
+
+        publish_snapshot();
+
+        count(m_counters.m_processTime, nanoseconds(std::chrono::steady_clock::now() - begin));
+    };
+
+    //*****************************************************************************************************
+    // AdaptTimeStep() - adjust time step after a block of iterations
+    //*****************************************************************************************************
+    // The step is limited by the largest displacement per step and by the energy change over the block,
+    // which for velocity Verlet scales as the square of the step. The step changes by at most
+    // a factor of 2 down and 1.25 up per block and stays within [m_minFactor, m_maxFactor].
+    //*****************************************************************************************************
+    //! @param [in] energy_change change of total energy over the block in J
+    //*****************************************************************************************************
+    void AdaptTimeStep(double energy_change)
+    {
+        double drift        = std::abs(energy_change) / (m_depth * std::max<size_t>(m_particles.size(), 1));
+        double displacement = (sqrt(m_maxV2) * m_timestep + sqrt(m_maxA2) * m_timestep * m_timestep / 2.) / m_sigma;
+
+        m_stepHistory.push_back({ uint32_t(m_iter), m_timestep, drift, displacement });
+
+        double scale = 1.25;
+
+        if (displacement > 0)
+            scale = std::min(scale, m_maxDisplacement / displacement);
+
+        if ((drift > 0) && (m_thermostat == Thermostat::None))
+            scale = std::min(scale, sqrt(m_driftBudget / drift));
+
+        scale = std::max(scale, 0.5);
+
+        m_timestep = std::clamp(m_timestep * scale,
+                                characteristic_time() * m_minFactor, characteristic_time() * m_maxFactor);
+    };
+
+    //*****************************************************************************************************
+    // SetAdaptiveTimeStep() - enable or disable adaptive time step
+    //*****************************************************************************************************
+    //! @param [in] enabled adjust time step between blocks of iterations
+    //! @param [in, optional] block number of iterations in one block
+    //! @param [in, optional] maxDisplacement allowed displacement per step in sigma
+    //! @param [in, optional] driftBudget allowed energy change per block and particle in units of the well depth
+    //*****************************************************************************************************
+    void SetAdaptiveTimeStep(bool enabled, uint32_t block = 100, double maxDisplacement = 0.05, double driftBudget = 1E-3)
+    {
+        m_adaptiveStep = enabled;
+
+        if (block > 0)
+            m_adaptiveBlock = block;
+        if (maxDisplacement > 0)
+            m_maxDisplacement = maxDisplacement;
+        if (driftBudget > 0)
+            m_driftBudget = driftBudget;
+    };
+
+    //*****************************************************************************************************
+    // GetTimeStepHistory() - get history of adaptive time steps
+    //*****************************************************************************************************
+    //! @return one record per block since the last SetInitialConditions()
+    //*****************************************************************************************************
+    const std::vector<TimeStepRecord>& GetTimeStepHistory()
+    {
+        return m_stepHistory;
+    };
+
+    //*****************************************************************************************************
+    // GetTimeStep() - get current time step
+    //*****************************************************************************************************
+    //! @return time step in s
+    //*****************************************************************************************************
+    double GetTimeStep()
+    {
+        return m_timestep;
+    };
+
+    //*****************************************************************************************************
+    // GetSimulatedTime() - get simulated time since initial conditions
+    //*****************************************************************************************************
+    //! @return time in s
+    //*****************************************************************************************************
+    double GetSimulatedTime()
+    {
+        return m_time;
     };
 
     //*****************************************************************************************************
     // Process() - process one iteration of modeling function
     //*****************************************************************************************************
-    void Process()
+    // Defined after the class, so that the core library keeps the kernels out of other translation units.
+    //*****************************************************************************************************
+    void Process();
+
+    //*****************************************************************************************************
+    // update_statistics() - add energies and temperature of the last iteration to statistics
+    //*****************************************************************************************************
+    void update_statistics()
+    {
+        if (m_particles.empty())
+            return;
+
+        m_temperatureStats.Add(2 * m_kE / (double(Dim) * m_particles.size() * m_boltzman));
+        m_kineticStats.Add(m_kE);
+        m_potentialStats.Add(m_pE);
+        m_energyStats.Add(m_kE + m_pE);
+    };
+
+    //*****************************************************************************************************
+    // ResetStatistics() - forget statistics, f.e. at the end of equilibration
+    //*****************************************************************************************************
+    void ResetStatistics()
+    {
+        m_temperatureStats.Reset();
+        m_kineticStats.Reset();
+        m_potentialStats.Reset();
+        m_energyStats.Reset();
+    };
+
+    //*****************************************************************************************************
+    // GetTemperatureStatistics() - get statistics of temperature in K since the last reset
+    //*****************************************************************************************************
+    //! @return mean and error bar of temperature
+    //*****************************************************************************************************
+    const BlockAverage& GetTemperatureStatistics() const
+    {
+        return m_temperatureStats;
+    };
+
+    //*****************************************************************************************************
+    // GetKineticEnergyStatistics() - get statistics of kinetic energy in J since the last reset
+    //*****************************************************************************************************
+    //! @return mean and error bar of kinetic energy
+    //*****************************************************************************************************
+    const BlockAverage& GetKineticEnergyStatistics() const
+    {
+        return m_kineticStats;
+    };
+
+    //*****************************************************************************************************
+    // GetPotentialEnergyStatistics() - get statistics of potential energy in J since the last reset
+    //*****************************************************************************************************
+    //! @return mean and error bar of potential energy
+    //*****************************************************************************************************
+    const BlockAverage& GetPotentialEnergyStatistics() const
     {
-        velocity_verlet_process(m_particles.begin(), m_particles.end(), particle_interaction);
-        ++m_iter;
+        return m_potentialStats;
+    };
 
-        return;
+    //*****************************************************************************************************
+    // GetEnergyStatistics() - get statistics of total energy in J since the last reset
+    //*****************************************************************************************************
+    //! @return mean and error bar of total energy
+    //*****************************************************************************************************
+    const BlockAverage& GetEnergyStatistics() const
+    {
+        return m_energyStats;
     };
 
     //*****************************************************************************************************
@@ -498,9 +2167,14 @@ public:     // methods
         {
             auto& p = m_particles.at(i);
 
-            if ( (p.m_x < m_spaceLeft) || (p.m_x > m_spaceRight) ||
-                 (p.m_y < m_spaceBot)  || (p.m_y > m_spaceTop) )
-                numOfLoss++;
+            for (size_t k = 0; k < Dim; ++k)
+            {
+                if ((p.m_r[k] < m_spaceMin[k]) || (p.m_r[k] > m_spaceMax[k]))
+                {
+                    numOfLoss++;
+                    break;
+                }
+            }
         }
 
         return numOfLoss;
@@ -528,17 +2202,14 @@ public:     // methods
 
         for (uint32_t i = 0; i < size; ++i)
         {
-            double x = m_particles.at(i).m_x;
-            double y = m_particles.at(i).m_y;
-
-            if (InBounds(x, y))
+            if (InBounds(m_particles.at(i).m_r))
               vSum += m_particles.at(i).GetMeanSVelocity();
-            else 
+            else
               m_particles.at(i).GetMeanSVelocity();
-            
+
         }
 
-        return (vSum * Particle::m_m / 2. / (double)size / m_boltzman);
+        return (vSum * ParticleType::m_m / double(Dim) / (double)size / m_boltzman);
     };
 
     //*****************************************************************************************************
@@ -554,4 +2225,53 @@ public:     // methods
 
 };
 
+//*********************************************************************************************************
+// BasicModel::Process() - process one iteration of modeling function
+//*********************************************************************************************************
+template <size_t Dim>
+void BasicModel<Dim>::Process()
+{
+    if (m_thermostat == Thermostat::NoseHoover)
+        nose_hoover_half_step(m_particles.begin(), m_particles.end());
+
+    if (m_integrator == Integrator::Respa)
+        respa_process(m_particles.begin(), m_particles.end());
+    else
+    {
+        velocity_verlet_process(m_particles.begin(), m_particles.end(), [this](ParticleType& p1, ParticleType& p2)
+                                { return particle_interaction(p1, p2); });
+        m_respaReady = false;
+    }
+
+    if (m_thermostat != Thermostat::None)
+        apply_thermostat(m_particles.begin(), m_particles.end());
+
+    ++m_iter;
+    m_time += m_timestep;
+
+    count(m_counters.m_iterations, 1);
+    count(m_counters.m_particleSteps, m_particles.size());
+
+    update_statistics();
+
+    return;
+}
+
+using Model   = BasicModel<2>;
+using Model3D = BasicModel<3>;
+
+//*********************************************************************************************************
+// Kernels of the core library
+//*********************************************************************************************************
+// With EVAPORATION_CORE defined by targets linked to the core library (core/CMakeLists.txt, core/core.pro)
+// the processing of models is instantiated once in the library, compiled there with its optimization
+// flags, instead of in every translation unit which includes this header.
+//*********************************************************************************************************
+#ifdef EVAPORATION_CORE
+extern template void BasicModel<2>::Process(uint32_t);
+extern template void BasicModel<2>::Process();
+extern template void BasicModel<3>::Process(uint32_t);
+extern template void BasicModel<3>::Process();
+#endif
+
 #endif    // EVAPORATION_H
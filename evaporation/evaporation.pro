@@ -14,13 +14,33 @@ SOURCES += \
     qcustomplot.cpp \
 
 HEADERS += \
+    density_map.h \
     evaporation.h \
     mainwindow.h \
     qcustomplot.h \
+    random.h \
+    ring_buffer.h \
+    simulation_scheduler.h \
+    span.h \
+    trajectory_codec.h \
+    trajectory_replay.h \
 
 FORMS += \
     mainwindow.ui
 
+# kernels of the engine are linked from the core library, built by ../evaporation_project.pro
+DEFINES += EVAPORATION_CORE
+
+win32:CONFIG(release, debug|release): CORE_DIR = $$OUT_PWD/../core/release
+else:win32:CONFIG(debug, debug|release): CORE_DIR = $$OUT_PWD/../core/debug
+else: CORE_DIR = $$OUT_PWD/../core
+
+LIBS += -L$$CORE_DIR -levaporation_core
+
+# the GUI is relinked when the static library changes
+win32-msvc*: PRE_TARGETDEPS += $$CORE_DIR/evaporation_core.lib
+else: PRE_TARGETDEPS += $$CORE_DIR/libevaporation_core.a
+
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
 else: unix:!android: target.path = /opt/$${TARGET}/bin
@@ -0,0 +1,1221 @@
+#ifndef LARGE_SYSTEM_H
+#define LARGE_SYSTEM_H
+
+#include "evaporation.h"
+#include "numa_topology.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+template <size_t Dim>
+class DomainSystem;
+
+//*********************************************************************************************************
+// UninitializedAllocator - allocator which leaves values of trivial types uninitialized on resize
+//*********************************************************************************************************
+// Pages of per-atom arrays are first touched by the threads which use them, not by resize().
+//*********************************************************************************************************
+template <typename T>
+struct UninitializedAllocator : std::allocator<T>
+{
+    template <typename U>
+    struct rebind
+    {
+        using other = UninitializedAllocator<U>;
+    };
+
+    UninitializedAllocator() = default;
+
+    template <typename U>
+    UninitializedAllocator(const UninitializedAllocator<U>&) {}
+
+    template <typename U, typename... Args>
+    void construct(U* p, Args&&... args)
+    {
+        if constexpr (sizeof...(Args) == 0)
+            ::new (static_cast<void*>(p)) U;
+        else
+            ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+    };
+};
+
+//*********************************************************************************************************
+// LargeSystem - molecular dynamics of 10^6 and more argon atoms in Dim dimensions
+//*********************************************************************************************************
+// Per-atom data is kept in separate arrays of coordinates, velocities and accelerations only,
+// which is 48 bytes per atom in 2D and 72 in 3D plus the cell list. The potential is cut at
+// m_cutoff and shifted to zero there, neighbours are found through cells not smaller than the cutoff,
+// so a step costs O(N). Atoms are reordered by cells every m_sortInterval steps to keep neighbours
+// close in memory. Forces, integration and observables are split between threads of ThreadPool,
+// every thread writes only forces of its own atoms, so no atomics are needed.
+// Copies of atoms of other domains, ghosts, may follow own atoms, they only act on own atoms
+// and are not integrated, see DomainSystem. With NUMA placement threads are pinned node by node and
+// every thread always gets the same range of atoms, whose pages it touched first.
+//*********************************************************************************************************
+template <size_t Dim>
+class LargeSystem
+{
+    static_assert((Dim == 2) || (Dim == 3), "only 2D and 3D systems are supported");
+
+    template <size_t D>
+    friend class DomainSystem;
+
+public:     // types
+
+    using Physics = BasicModel<Dim>;                                                 //!< Model with constants and pair potential
+    using Vector  = std::array<double, Dim>;                                         //!< Point or vector in modeling space
+    template <typename T>
+    using Buffer  = std::vector<T, UninitializedAllocator<T>>;                       //!< Per-atom array
+    using Arrays  = std::array<Buffer<double>, Dim>;                                 //!< One array of values per axis
+
+    //*****************************************************************************************************
+    // NeighbourBuffer - particles of one cell and adjacent cells gathered by one thread
+    //*****************************************************************************************************
+    struct NeighbourBuffer
+    {
+        Buffer<uint32_t>      m_index;                                               //!< Indices of particles
+        Arrays                m_r;                                                   //!< Coordinates of particles
+    };
+
+private:    // variables
+
+    constexpr static double m_m        = BasicParticle<Dim>::m_m;                    //!< Mass of particle
+
+    size_t    m_size                   = 0;                                          //!< Number of particles including ghosts
+    size_t    m_owned                  = 0;                                          //!< Number of own particles, ghosts follow them
+    Arrays    m_r;                                                                   //!< Coordinates
+    Arrays    m_v;                                                                   //!< Velocities
+    Arrays    m_a;                                                                   //!< Accelerations
+    Buffer<double>        m_scratch;                                                 //!< Buffer for reordering of one array
+
+    Buffer<uint32_t>      m_order;                                                   //!< Particles sorted by cells
+    std::vector<uint32_t> m_cellStart;                                               //!< First position of every cell in m_order
+    std::vector<uint32_t> m_cellFill;                                                //!< Fill cursor of every cell while sorting
+    std::array<uint32_t, Dim> m_cells  = {};                                         //!< Number of cells along every axis
+    Vector    m_invCell                = {};                                         //!< Inverse cell sizes
+    uint32_t  m_sortInterval           = 16;                                         //!< Particles are reordered by cells every that many steps
+    Vector    m_gridMin                = {};                                         //!< Lower corner of the cell grid
+    Vector    m_gridMax                = Physics::filled(30 * Physics::m_equilibrium_distance);  //!< Upper corner of the cell grid
+
+    Vector    m_spaceMin               = {};                                         //!< Position of the left, bot (and near) walls of the modeling area
+    Vector    m_spaceMax               = Physics::filled(30 * Physics::m_equilibrium_distance);  //!< Position of the right, top (and far) walls
+    Boundary  m_boundary               = Boundary::Open;                             //!< Type of boundaries
+    Vector    m_period                 = {};                                         //!< Periods for minimum image
+    Vector    m_invPeriod              = {};                                         //!< Inverse periods of minimum image and cells, 0 along not periodic axes
+    Vector    m_invWrap                = {};                                         //!< Inverse periods positions are wrapped by, kept where ghosts give images
+
+    double    m_cutoff                 = 2.5 * Physics::m_sigma;                     //!< Cutoff distance of the potential
+    double    m_shift                  = 0;                                          //!< Potential at the cutoff distance
+
+    uint32_t  m_iter                   = 0;                                          //!< Current value of iterations
+    double    m_timestep               = 0;                                          //!< Time step of modeling
+    double    m_temp                   = 1;                                          //!< Init temprature in K
+    double    m_kE                     = 0;                                          //!< Kinetic energy on the last iteration
+    double    m_pE                     = 0;                                          //!< Potencial energy on the last iteration
+    double    m_kESum                  = 0;                                          //!< Kinetic energy sum
+    double    m_pESum                  = 0;                                          //!< Potencial energy sum
+
+    double    m_elapsed                = 0;                                          //!< Wall time of Process() in ns
+    double    m_atomSteps              = 0;                                          //!< Number of processed atom-steps
+
+    std::unique_ptr<ThreadPool> m_pool = std::make_unique<ThreadPool>();             //!< Threads for kernels
+    NumaTopology          m_topology;                                                //!< NUMA nodes of CPUs of the process
+    bool                  m_numa = false;                                            //!< Threads are pinned and own fixed ranges of atoms
+    std::vector<double>   m_threadSum;                                               //!< Partial sums of every thread, one cache line apart
+    std::vector<NeighbourBuffer> m_threadBuffer;                                     //!< Gathered neighbours of one cell for every thread
+
+    std::mutex      protection_mutex;                                                //!< Mutex for coordinates
+    std::mt19937_64 m_gen{std::random_device{}()};                                   //!< Generator for initial velocities
+
+    constexpr static size_t m_stride   = 64 / sizeof(double);                        //!< Distance between partial sums of threads
+    constexpr static size_t m_rowSize  = 64;                                         //!< Number of neighbours processed at once in the force loop
+
+public:     // methods
+
+    //*****************************************************************************************************
+    // SetThreads() - set number of threads for kernels
+    //*****************************************************************************************************
+    //! @param [in] threads number of threads including the caller, 0 means hardware concurrency
+    //*****************************************************************************************************
+    void SetThreads(size_t threads)
+    {
+        // the old pool gives the caller its CPUs back before workers of the new one inherit them
+        m_pool.reset();
+        m_pool = std::make_unique<ThreadPool>(threads, m_numa ? m_topology.GetCpus() : std::vector<int>());
+
+        set_thread_data();
+        first_touch();
+    };
+
+    //*****************************************************************************************************
+    // SetNumaPlacement() - pin threads node by node and give them fixed ranges of atoms
+    //*****************************************************************************************************
+    // Per-atom arrays are reallocated and first touched by their threads, so they are placed on
+    // the nodes of the threads. Dynamic balancing of threads is off in this mode.
+    //*****************************************************************************************************
+    //! @param [in] numa true to enable placement
+    //*****************************************************************************************************
+    void SetNumaPlacement(bool numa)
+    {
+        m_numa = numa;
+
+        SetThreads(m_pool->GetThreadsAmount());
+    };
+
+    //*****************************************************************************************************
+    // GetNodesAmount() - get number of NUMA nodes with CPUs of the process
+    //*****************************************************************************************************
+    //! @return number of nodes
+    //*****************************************************************************************************
+    int GetNodesAmount()
+    {
+        return m_topology.GetNodesAmount();
+    };
+
+    //*****************************************************************************************************
+    // GetThreadsAmount() - get number of threads for kernels
+    //*****************************************************************************************************
+    //! @return number of threads
+    //*****************************************************************************************************
+    size_t GetThreadsAmount()
+    {
+        return m_pool->GetThreadsAmount();
+    };
+
+    //*****************************************************************************************************
+    // SetTemperature() - set initial temperature in K
+    //*****************************************************************************************************
+    //! @param [in] t value of init temperature in K
+    //*****************************************************************************************************
+    void SetTemperature(double t)
+    {
+        if (t >= 0)
+            m_temp = t;
+    };
+
+    //*****************************************************************************************************
+    // SetSeed() - seed generator of initial velocities
+    //*****************************************************************************************************
+    //! @param [in] seed value of seed
+    //*****************************************************************************************************
+    void SetSeed(uint64_t seed)
+    {
+        m_gen.seed(seed);
+    };
+
+    //*****************************************************************************************************
+    // SetCutoff() - set cutoff distance of the potential
+    //*****************************************************************************************************
+    //! @param [in] cutoff distance in sigma
+    //*****************************************************************************************************
+    void SetCutoff(double cutoff)
+    {
+        if (cutoff > 1)
+            m_cutoff = cutoff * Physics::m_sigma;
+    };
+
+    //*****************************************************************************************************
+    // SetSortInterval() - set number of steps between reorderings of particles by cells
+    //*****************************************************************************************************
+    //! @param [in] steps number of steps, 0 disables reordering
+    //*****************************************************************************************************
+    void SetSortInterval(uint32_t steps)
+    {
+        m_sortInterval = steps;
+    };
+
+    //*****************************************************************************************************
+    // EvaluateTimeStep() - evaluate time step funtion, same as Model::EvaluateTimeStep()
+    //*****************************************************************************************************
+    //! @param [in, optional] factor value of factor of time step for adjustment
+    //*****************************************************************************************************
+    double EvaluateTimeStep(double factor = 0.01)
+    {
+        if (factor <= 0)
+            factor = 0.01;
+
+        m_timestep = factor * Physics::characteristic_time();
+
+        return m_timestep;
+    };
+
+    //*****************************************************************************************************
+    // GetEquilibriumDistance() - get equilibrium distanse between particles function
+    //*****************************************************************************************************
+    //! @return equilibrium distance
+    //*****************************************************************************************************
+    double GetEquilibriumDistance()
+    {
+        return Physics::m_equilibrium_distance;
+    };
+
+    //*****************************************************************************************************
+    // SetBoundaries() - set type of boundaries of the modeling area
+    //*****************************************************************************************************
+    //! @param [in] boundary type of boundaries
+    //*****************************************************************************************************
+    void SetBoundaries(Boundary boundary)
+    {
+        m_boundary = boundary;
+
+        for (size_t k = 0; k < Dim; ++k)
+        {
+            m_period[k]    = m_spaceMax[k] - m_spaceMin[k];
+            m_invPeriod[k] = (boundary == Boundary::Periodic) ? 1 / m_period[k] : 0;
+            m_invWrap[k]   = m_invPeriod[k];
+        }
+    };
+
+    //*****************************************************************************************************
+    // SetModelingSpace() - set size of the modeling area
+    //*****************************************************************************************************
+    //! @param [in] sizes width, height (and depth) of the area in m
+    //*****************************************************************************************************
+    template <typename... Sizes>
+    void SetModelingSpace(Sizes... sizes)
+    {
+        static_assert(sizeof...(Sizes) == Dim, "one size per axis is expected");
+
+        Vector size = { double(sizes)... };
+
+        for (size_t k = 0; k < Dim; ++k)
+            if (size[k] <= 0)
+                return;
+
+        m_spaceMin = {};
+        m_spaceMax = size;
+        m_gridMin  = m_spaceMin;
+        m_gridMax  = m_spaceMax;
+
+        SetBoundaries(m_boundary);
+    };
+
+    //*****************************************************************************************************
+    // SetInitialConditions() - set planar grid as initial conditions, same layout as Model
+    //*****************************************************************************************************
+    //! @param [in] width number of nodes along the y axis
+    //! @param [in] height number of nodes along the x axis
+    //! @param [in] period period of grid
+    //*****************************************************************************************************
+    void SetInitialConditions(int width, int height, double period)
+    {
+        static_assert(Dim == 2, "planar grid needs two dimensional system");
+
+        if ((width <= 1) || (height <= 1) || (period < 0))
+            return;
+
+        allocate(size_t(width) * height);
+
+        for (size_t i = 0; i < m_size; ++i)
+        {
+            m_r[0][i] = (m_spaceMax[0] - m_spaceMin[0]) / 2. + (- height / 2 + int(i / width)) * period;
+            m_r[1][i] = (m_spaceMax[1] - m_spaceMin[1]) / 2. + (- width / 2 + int(i % width)) * period;
+        }
+
+        start();
+    };
+
+    //*****************************************************************************************************
+    // SetInitialConditions() - set simple cubic grid as initial conditions, same layout as Model3D
+    //*****************************************************************************************************
+    //! @param [in] width number of nodes along the y axis
+    //! @param [in] height number of nodes along the x axis
+    //! @param [in] depth number of nodes along the z axis
+    //! @param [in] period period of grid
+    //*****************************************************************************************************
+    void SetInitialConditions(int width, int height, int depth, double period)
+    {
+        static_assert(Dim == 3, "spatial grid needs three dimensional system");
+
+        if ((width <= 1) || (height <= 1) || (depth <= 1) || (period < 0))
+            return;
+
+        allocate(size_t(width) * height * depth);
+
+        for (size_t i = 0; i < m_size; ++i)
+        {
+            m_r[0][i] = (m_spaceMax[0] - m_spaceMin[0]) / 2. + (- height / 2 + int(i / (width * depth))) * period;
+            m_r[1][i] = (m_spaceMax[1] - m_spaceMin[1]) / 2. + (- width / 2 + int(i / depth % width)) * period;
+            m_r[2][i] = (m_spaceMax[2] - m_spaceMin[2]) / 2. + (- depth / 2 + int(i % depth)) * period;
+        }
+
+        start();
+    };
+
+    //*****************************************************************************************************
+    // Process() - process some iterations of modeling function
+    //*****************************************************************************************************
+    // Defined after the class like BasicModel::Process(), members defined in the class are inline and
+    // their kernels would be compiled in every translation unit despite the core library.
+    //*****************************************************************************************************
+    //! @param [in] iterations value of iterations to process
+    //*****************************************************************************************************
+    void Process(uint32_t iterations);
+
+    //*****************************************************************************************************
+    // Process() - process one iteration, velocity Verlet in kick-drift-kick form
+    //*****************************************************************************************************
+    void Process();
+
+    //*****************************************************************************************************
+    // ReadPositions() - give coordinates to a reader without copying them
+    //*****************************************************************************************************
+    // The reader is called under the mutex with one pointer per axis and the number of particles,
+    // so the pointers must not be kept after it returns.
+    //*****************************************************************************************************
+    //! @param [in] reader function called as reader(const std::array<const double*, Dim>&, size_t)
+    //*****************************************************************************************************
+    template <typename Reader>
+    void ReadPositions(Reader reader)
+    {
+        std::lock_guard<std::mutex> lock(protection_mutex);
+
+        std::array<const double*, Dim> r;
+
+        for (size_t k = 0; k < Dim; ++k)
+            r[k] = m_r[k].data();
+
+        reader(r, m_owned);
+    };
+
+    //*****************************************************************************************************
+    // GetPotentialEnergySum() - get potensial energy sum and set p.e. as zero
+    //*****************************************************************************************************
+    //! @return potential energy sum
+    //*****************************************************************************************************
+    double GetPotentialEnergySum()
+    {
+        double pe      = m_pESum;
+               m_pESum = 0;
+
+        return pe;
+    };
+
+    //*****************************************************************************************************
+    // GetKineticEnergySum() - get kinetic energy sum and set k.e. as zero
+    //*****************************************************************************************************
+    //! @return kinetic energy sum
+    //*****************************************************************************************************
+    double GetKineticEnergySum()
+    {
+        double ke      = m_kESum;
+               m_kESum = 0;
+
+        return ke;
+    };
+
+    //*****************************************************************************************************
+    // GetTemperature() - get temperature on the last iteration in K
+    //*****************************************************************************************************
+    //! @return temperature in Kelvin
+    //*****************************************************************************************************
+    double GetTemperature()
+    {
+        return (m_owned > 0) ? 2 * m_kE / (double(Dim) * m_owned * Physics::m_boltzman) : 0;
+    };
+
+    //*****************************************************************************************************
+    // GetParticlesLoss() - get cur value of particles out of modeling space
+    //*****************************************************************************************************
+    //! @return number of lost particles
+    //*****************************************************************************************************
+    uint32_t GetParticlesLoss()
+    {
+        return uint32_t(reduce([&](size_t first, size_t last)
+        {
+            double loss = 0;
+
+            for (size_t i = first; i < last; ++i)
+            {
+                bool out = false;
+
+                for (size_t k = 0; k < Dim; ++k)
+                    out = out || (m_r[k][i] < m_spaceMin[k]) || (m_r[k][i] > m_spaceMax[k]);
+
+                loss += out;
+            }
+
+            return loss;
+        }));
+    };
+
+    //*****************************************************************************************************
+    // GetParticlesAmount() - get number of particles
+    //*****************************************************************************************************
+    //! @return number of particles
+    //*****************************************************************************************************
+    size_t GetParticlesAmount()
+    {
+        return m_owned;
+    };
+
+    //*****************************************************************************************************
+    // GetIteration() - get cur value of iteration function
+    //*****************************************************************************************************
+    //! @return value of cur iteration
+    //*****************************************************************************************************
+    uint32_t GetIteration()
+    {
+        return m_iter;
+    };
+
+    //*****************************************************************************************************
+    // GetBytesPerAtom() - get memory used by per-atom and cell arrays divided by number of particles
+    //*****************************************************************************************************
+    //! @return bytes per atom
+    //*****************************************************************************************************
+    double GetBytesPerAtom()
+    {
+        if (m_size == 0)
+            return 0;
+
+        size_t bytes = m_scratch.capacity() * sizeof(double) +
+                       (m_order.capacity() + m_cellStart.capacity() + m_cellFill.capacity()) * sizeof(uint32_t);
+
+        for (size_t k = 0; k < Dim; ++k)
+            bytes += (m_r[k].capacity() + m_v[k].capacity() + m_a[k].capacity()) * sizeof(double);
+
+        for (auto& buffer : m_threadBuffer)
+        {
+            bytes += buffer.m_index.capacity() * sizeof(uint32_t);
+
+            for (size_t k = 0; k < Dim; ++k)
+                bytes += buffer.m_r[k].capacity() * sizeof(double);
+        }
+
+        return double(bytes) / m_size;
+    };
+
+    //*****************************************************************************************************
+    // GetNsPerAtomStep() - get mean wall time of one step of one atom in Process()
+    //*****************************************************************************************************
+    //! @return time in ns
+    //*****************************************************************************************************
+    double GetNsPerAtomStep()
+    {
+        return (m_atomSteps > 0) ? m_elapsed / m_atomSteps : 0;
+    };
+
+    //*****************************************************************************************************
+    // GetRemoteAccessRatio() - get part of pages of per-atom arrays which are not on the node of
+    // the thread which integrates these atoms
+    //*****************************************************************************************************
+    // Threads are assigned to ranges of atoms as in NUMA placement. Pages shared by two ranges
+    // are counted for both.
+    //*****************************************************************************************************
+    //! @return ratio from 0 to 1, negative if nodes of pages or threads are not known
+    //*****************************************************************************************************
+    double GetRemoteAccessRatio()
+    {
+        std::vector<size_t> remote(m_pool->GetThreadsAmount(), 0);
+        std::vector<size_t> known(m_pool->GetThreadsAmount(), 0);
+
+        std::lock_guard<std::mutex> lock(protection_mutex);
+
+        std::atomic<bool> queried {true};
+
+        m_pool->StaticFor(0, m_owned, [&](size_t first, size_t last, size_t thread)
+        {
+            int node = m_topology.GetNodeOfCpu(NumaTopology::GetCurrentCpu());
+
+            std::vector<int> nodes;
+
+            for (auto* arrays : {&m_r, &m_v, &m_a})
+            {
+                for (auto& values : *arrays)
+                {
+                    if (!NumaTopology::GetPageNodes(values.data() + first, (last - first) * sizeof(double), nodes) || (node < 0))
+                    {
+                        queried.store(false, std::memory_order_relaxed);
+                        return;
+                    }
+
+                    for (int n : nodes)
+                    {
+                        known[thread]  += (n >= 0);
+                        remote[thread] += (n >= 0) && (n != node);
+                    }
+                }
+            }
+        });
+
+        size_t remote_pages = std::accumulate(remote.begin(), remote.end(), size_t(0));
+        size_t known_pages  = std::accumulate(known.begin(), known.end(), size_t(0));
+
+        if (!queried.load(std::memory_order_relaxed))
+            return -1;
+
+        return (known_pages > 0) ? double(remote_pages) / known_pages : 0;
+    };
+
+private:    // methods
+
+    //*****************************************************************************************************
+    // for_atoms() - run body over ranges of atoms on all threads, ranges are fixed with NUMA placement
+    //*****************************************************************************************************
+    //! @param [in] begin first index
+    //! @param [in] end index after the last one
+    //! @param [in] body function called as body(first, last, thread)
+    //*****************************************************************************************************
+    template <typename Body>
+    void for_atoms(size_t begin, size_t end, Body&& body)
+    {
+        if (m_numa)
+            m_pool->StaticFor(begin, end, body);
+        else
+            m_pool->ParallelFor(begin, end, body);
+    };
+
+    //*****************************************************************************************************
+    // first_touch() - reallocate per-atom arrays and write them by the threads which use them
+    //*****************************************************************************************************
+    // Values are kept, the new pages are placed on the nodes of the threads which wrote them first.
+    //*****************************************************************************************************
+    void first_touch()
+    {
+        if (m_size == 0)
+            return;
+
+        auto touch = [&](auto& values)
+        {
+            std::remove_reference_t<decltype(values)> placed;
+
+            placed.resize(values.size());
+
+            m_pool->StaticFor(0, values.size(), [&](size_t first, size_t last, size_t)
+            {
+                std::copy(values.begin() + first, values.begin() + last, placed.begin() + first);
+            });
+
+            values.swap(placed);
+        };
+
+        std::lock_guard<std::mutex> lock(protection_mutex);
+
+        for (auto* arrays : {&m_r, &m_v, &m_a})
+            for (auto& values : *arrays)
+                touch(values);
+
+        touch(m_scratch);
+        touch(m_order);
+    };
+
+    //*****************************************************************************************************
+    // kick_drift() - first half kick of velocities and drift of own particles
+    //*****************************************************************************************************
+    void kick_drift()
+    {
+        double dt = m_timestep;
+
+        for_atoms(0, m_owned, [&](size_t first, size_t last, size_t)
+        {
+            for (size_t k = 0; k < Dim; ++k)
+            {
+                double*       r = m_r[k].data();
+                double*       v = m_v[k].data();
+                const double* a = m_a[k].data();
+
+                for (size_t i = first; i < last; ++i)
+                {
+                    v[i] += a[i] * dt / 2.;
+                    r[i] += v[i] * dt;
+                }
+            }
+
+            apply_boundaries(first, last);
+        });
+    };
+
+    //*****************************************************************************************************
+    // kick() - second half kick of velocities of own particles, ends the iteration
+    //*****************************************************************************************************
+    void kick()
+    {
+        double dt = m_timestep;
+
+        m_kE     = reduce([&](size_t first, size_t last)
+        {
+            double kinetic_energy = 0;
+
+            for (size_t k = 0; k < Dim; ++k)
+            {
+                double*       v = m_v[k].data();
+                const double* a = m_a[k].data();
+
+                for (size_t i = first; i < last; ++i)
+                {
+                    v[i] += a[i] * dt / 2.;
+                    kinetic_energy += m_m * v[i] * v[i] / 2.;
+                }
+            }
+
+            return kinetic_energy;
+        });
+        m_kESum += m_kE;
+
+        ++m_iter;
+    };
+
+    //*****************************************************************************************************
+    // resize() - change number of particles keeping data of the first ones
+    //*****************************************************************************************************
+    //! @param [in] size number of particles including ghosts
+    //! @param [in] owned number of own particles
+    //*****************************************************************************************************
+    void resize(size_t size, size_t owned)
+    {
+        m_size  = size;
+        m_owned = owned;
+
+        for (size_t k = 0; k < Dim; ++k)
+        {
+            m_r[k].resize(m_size);
+            m_v[k].resize(m_size);
+            m_a[k].resize(m_size);
+        }
+
+        m_scratch.resize(m_size);
+        m_order.resize(m_size);
+    };
+
+    //*****************************************************************************************************
+    // allocate() - size per-atom arrays and reset counters
+    //*****************************************************************************************************
+    //! @param [in] size number of particles
+    //*****************************************************************************************************
+    void allocate(size_t size)
+    {
+        m_size      = size;
+        m_owned     = size;
+        m_iter      = 0;
+        m_kESum     = 0;
+        m_pESum     = 0;
+        m_elapsed   = 0;
+        m_atomSteps = 0;
+
+        // fresh arrays are left untouched here and zeroed by the threads which use them
+        auto zero = [&](auto& values)
+        {
+            std::remove_reference_t<decltype(values)>().swap(values);
+
+            values.resize(m_size);
+
+            m_pool->StaticFor(0, m_size, [&](size_t first, size_t last, size_t)
+            {
+                std::fill(values.begin() + first, values.begin() + last, 0);
+            });
+        };
+
+        for (auto* arrays : {&m_r, &m_v, &m_a})
+            for (auto& values : *arrays)
+                zero(values);
+
+        zero(m_scratch);
+        zero(m_order);
+    };
+
+    //*****************************************************************************************************
+    // start() - set velocities, cells and forces for new coordinates
+    //*****************************************************************************************************
+    void start()
+    {
+        double ir2 = 1 / (m_cutoff * m_cutoff);
+        double s6  = Physics::m_sigma6 * ir2 * ir2 * ir2;
+
+        m_shift = 4 * Physics::m_depth * s6 * (s6 - 1);
+
+        set_cells();
+        set_thread_data();
+        set_velocities();
+
+        {
+            std::lock_guard<std::mutex> lock(protection_mutex);
+
+            sort_by_cells(true);
+        }
+
+        m_pE = forces();
+    };
+
+    //*****************************************************************************************************
+    // set_velocities() - velocities of equal modul in random directions with zero total momentum
+    //*****************************************************************************************************
+    void set_velocities()
+    {
+        double V = sqrt(Dim / 2. * Physics::m_boltzman * m_temp / m_m);
+
+        std::normal_distribution<> dist;
+
+        Vector sumV = {};
+
+        for (size_t i = 0; i < m_size; ++i)
+        {
+            Vector dir;
+
+            do
+            {
+                for (size_t k = 0; k < Dim; ++k)
+                    dir[k] = dist(m_gen);
+            }
+            while (squared_norm(dir) == 0);
+
+            double scale = V / sqrt(squared_norm(dir));
+
+            for (size_t k = 0; k < Dim; ++k)
+            {
+                m_v[k][i] = scale * dir[k];
+                sumV[k]  += m_v[k][i];
+            }
+        }
+
+        for (size_t k = 0; k < Dim; ++k)
+            for (size_t i = 0; i < m_size; ++i)
+                m_v[k][i] -= sumV[k] / m_size;
+    };
+
+    //*****************************************************************************************************
+    // set_cells() - choose cell grid for the modeling area
+    //*****************************************************************************************************
+    // Cells are not smaller than the cutoff. In a large sparse area they are made bigger,
+    // so that there are at most two cells per particle.
+    //*****************************************************************************************************
+    void set_cells()
+    {
+        double total = 1;
+
+        for (size_t k = 0; k < Dim; ++k)
+        {
+            m_cells[k] = std::max<uint32_t>(1, uint32_t((m_gridMax[k] - m_gridMin[k]) / m_cutoff));
+            total     *= m_cells[k];
+        }
+
+        if (total > 2. * m_size)
+        {
+            double scale = pow(total / (2. * m_size), 1. / Dim);
+
+            total = 1;
+
+            for (size_t k = 0; k < Dim; ++k)
+            {
+                m_cells[k] = std::max<uint32_t>(1, uint32_t(m_cells[k] / scale));
+                total     *= m_cells[k];
+            }
+        }
+
+        for (size_t k = 0; k < Dim; ++k)
+            m_invCell[k] = m_cells[k] / (m_gridMax[k] - m_gridMin[k]);
+
+        m_cellStart.assign(size_t(total) + 1, 0);
+        m_cellFill.assign(size_t(total), 0);
+    };
+
+    //*****************************************************************************************************
+    // set_thread_data() - allocate partial sums and buffers for every thread
+    //*****************************************************************************************************
+    void set_thread_data()
+    {
+        size_t threads = m_pool->GetThreadsAmount();
+
+        m_threadSum.assign(threads * m_stride, 0.0);
+        m_threadBuffer.assign(threads, NeighbourBuffer());
+    };
+
+    //*****************************************************************************************************
+    // cell_coordinate() - index of cell along one axis, particles outside are put into border cells
+    //*****************************************************************************************************
+    //! @param [in] x coordinate along the axis
+    //! @param [in] k index of the axis
+    //! @return index of cell
+    //*****************************************************************************************************
+    uint32_t cell_coordinate(double x, size_t k) const
+    {
+        double c = (x - m_gridMin[k]) * m_invCell[k];
+
+        // also NaN, which can not be converted to an integer
+        if (!(c > 0))
+            return 0;
+
+        return uint32_t(std::min(c, double(m_cells[k] - 1)));
+    };
+
+    //*****************************************************************************************************
+    // cell_of() - index of cell of particle
+    //*****************************************************************************************************
+    //! @param [in] i index of particle
+    //! @return index of cell
+    //*****************************************************************************************************
+    uint32_t cell_of(size_t i) const
+    {
+        uint32_t cell = 0;
+
+        for (size_t k = 0; k < Dim; ++k)
+            cell = cell * m_cells[k] + cell_coordinate(m_r[k][i], k);
+
+        return cell;
+    };
+
+    //*****************************************************************************************************
+    // sort_by_cells() - counting sort of particles by cells
+    //*****************************************************************************************************
+    //! @param [in] reorder move particle data into the sorted order, only when there are no ghosts
+    //*****************************************************************************************************
+    void sort_by_cells(bool reorder)
+    {
+        size_t cells = m_cellFill.size();
+
+        std::fill(m_cellStart.begin(), m_cellStart.end(), 0);
+
+        for (size_t i = 0; i < m_size; ++i)
+            ++m_cellStart[cell_of(i) + 1];
+
+        for (size_t c = 0; c < cells; ++c)
+            m_cellStart[c + 1] += m_cellStart[c];
+
+        std::copy(m_cellStart.begin(), m_cellStart.end() - 1, m_cellFill.begin());
+
+        for (size_t i = 0; i < m_size; ++i)
+            m_order[m_cellFill[cell_of(i)]++] = uint32_t(i);
+
+        if (!reorder || (m_owned < m_size))
+            return;
+
+        for (auto* arrays : {&m_r, &m_v, &m_a})
+        {
+            for (auto& values : *arrays)
+            {
+                for_atoms(0, m_size, [&](size_t first, size_t last, size_t)
+                {
+                    for (size_t i = first; i < last; ++i)
+                        m_scratch[i] = values[m_order[i]];
+                });
+
+                values.swap(m_scratch);
+            }
+        }
+
+        std::iota(m_order.begin(), m_order.end(), 0);
+    };
+
+    //*****************************************************************************************************
+    // apply_boundaries() - wrap or reflect particles which crossed the walls
+    //*****************************************************************************************************
+    //! @param [in] first index of the first particle
+    //! @param [in] last index after the last particle
+    //*****************************************************************************************************
+    void apply_boundaries(size_t first, size_t last)
+    {
+        if (m_boundary == Boundary::Periodic)
+        {
+            for (size_t k = 0; k < Dim; ++k)
+                for (size_t i = first; i < last; ++i)
+                    m_r[k][i] -= m_period[k] * std::floor((m_r[k][i] - m_spaceMin[k]) * m_invWrap[k]);
+        }
+        else if (m_boundary == Boundary::Reflecting)
+        {
+            for (size_t k = 0; k < Dim; ++k)
+            {
+                for (size_t i = first; i < last; ++i)
+                {
+                    if ((m_r[k][i] < m_spaceMin[k]) || (m_r[k][i] > m_spaceMax[k]))
+                    {
+                        m_r[k][i] = (m_r[k][i] < m_spaceMin[k]) ? 2 * m_spaceMin[k] - m_r[k][i] : 2 * m_spaceMax[k] - m_r[k][i];
+                        m_v[k][i] = - m_v[k][i];
+                    }
+                }
+            }
+        }
+    };
+
+    //*****************************************************************************************************
+    // reduce() - sum of function values over chunks of particles on all threads
+    //*****************************************************************************************************
+    //! @param [in] func function called as func(first, last) which returns sum over the chunk
+    //! @return total sum
+    //*****************************************************************************************************
+    template <typename Func>
+    double reduce(Func func)
+    {
+        std::fill(m_threadSum.begin(), m_threadSum.end(), 0.0);
+
+        for_atoms(0, m_owned, [&](size_t first, size_t last, size_t thread)
+        {
+            m_threadSum[thread * m_stride] += func(first, last);
+        });
+
+        double sum = 0;
+
+        for (size_t t = 0; t < m_threadSum.size(); t += m_stride)
+            sum += m_threadSum[t];
+
+        return sum;
+    };
+
+    //*****************************************************************************************************
+    // gather_neighbours() - copy coordinates of particles in the cell and adjacent cells into thread buffer
+    //*****************************************************************************************************
+    //! @param [in] cell index of cell
+    //! @param [in] thread index of thread
+    //! @return number of gathered particles
+    //*****************************************************************************************************
+    size_t gather_neighbours(size_t cell, size_t thread)
+    {
+        auto& buffer = m_threadBuffer[thread];
+        auto& index  = buffer.m_index;
+
+        index.clear();
+
+        std::array<uint32_t, Dim> c;
+
+        for (size_t k = Dim, rest = cell; k-- > 0; rest /= m_cells[k])
+            c[k] = rest % m_cells[k];
+
+        // range of offsets along every axis, cells are not repeated when there are less than 3 of them
+        std::array<int, Dim> lo, hi;
+
+        for (size_t k = 0; k < Dim; ++k)
+        {
+            if (m_invPeriod[k] > 0)
+            {
+                lo[k] = (m_cells[k] < 3) ? - int(c[k]) : -1;
+                hi[k] = (m_cells[k] < 3) ? int(m_cells[k] - 1 - c[k]) : 1;
+            }
+            else
+            {
+                lo[k] = (c[k] > 0) ? -1 : 0;
+                hi[k] = (c[k] + 1 < m_cells[k]) ? 1 : 0;
+            }
+        }
+
+        std::array<int, Dim> offset = lo;
+
+        while (true)
+        {
+            uint32_t neighbour = 0;
+
+            for (size_t k = 0; k < Dim; ++k)
+                neighbour = neighbour * m_cells[k] + (c[k] + offset[k] + m_cells[k]) % m_cells[k];
+
+            for (uint32_t n = m_cellStart[neighbour]; n < m_cellStart[neighbour + 1]; ++n)
+                index.push_back(m_order[n]);
+
+            size_t k = 0;
+
+            for (; k < Dim; ++k)
+            {
+                if (++offset[k] <= hi[k])
+                    break;
+
+                offset[k] = lo[k];
+            }
+
+            if (k == Dim)
+                break;
+        }
+
+        for (size_t k = 0; k < Dim; ++k)
+        {
+            buffer.m_r[k].resize(index.size());
+
+            for (size_t n = 0; n < index.size(); ++n)
+                buffer.m_r[k][n] = m_r[k][index[n]];
+        }
+
+
+        return index.size();
+    };
+
+    //*****************************************************************************************************
+    // forces() - evaluate accelerations of all particles over the cell list
+    //*****************************************************************************************************
+    // Every pair is evaluated twice, once for each particle, so threads never write forces of
+    // particles of other threads. Defined after the class, it is also called out of Process().
+    //*****************************************************************************************************
+    //! @return potential energy of the system
+    //*****************************************************************************************************
+    double forces();
+};
+
+//*********************************************************************************************************
+// LargeSystem::Process() - process some iterations of modeling function
+//*********************************************************************************************************
+template <size_t Dim>
+void LargeSystem<Dim>::Process(uint32_t iterations)
+{
+    auto begin = std::chrono::steady_clock::now();
+
+    for (uint32_t i = 0; i < iterations; ++i)
+        Process();
+
+    m_elapsed   += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+    m_atomSteps += double(iterations) * m_owned;
+}
+
+//*********************************************************************************************************
+// LargeSystem::Process() - process one iteration, velocity Verlet in kick-drift-kick form
+//*********************************************************************************************************
+template <size_t Dim>
+void LargeSystem<Dim>::Process()
+{
+    {
+        std::lock_guard<std::mutex> lock(protection_mutex);
+
+        kick_drift();
+        sort_by_cells((m_sortInterval > 0) && (m_iter % m_sortInterval == 0));
+    }
+
+    m_pE     = forces();
+    m_pESum += m_pE;
+
+    kick();
+}
+
+//*********************************************************************************************************
+// LargeSystem::forces() - evaluate accelerations of all particles over the cell list
+//*********************************************************************************************************
+template <size_t Dim>
+double LargeSystem<Dim>::forces()
+{
+    const double rc2    = m_cutoff * m_cutoff;
+    const double rmin2  = 0.01 * Physics::m_sigma * Physics::m_sigma;
+    const double middle = (rc2 + rmin2) / 2;
+    const double half   = (rc2 - rmin2) / 2;
+    const double shift  = m_shift;
+
+    std::fill(m_threadSum.begin(), m_threadSum.end(), 0.0);
+
+    auto cells_forces = [&](size_t first, size_t last, size_t thread)
+    {
+        double potential_energy = 0;
+
+        double period[Dim], inv_period[Dim];
+
+        for (size_t k = 0; k < Dim; ++k)
+        {
+            period[k]     = m_period[k];
+            inv_period[k] = m_invPeriod[k];
+        }
+
+        for (size_t cell = first; cell < last; ++cell)
+        {
+            if (m_cellStart[cell] == m_cellStart[cell + 1])
+                continue;
+
+            size_t count  = gather_neighbours(cell, thread);
+
+            const double* rj[Dim];
+
+            for (size_t k = 0; k < Dim; ++k)
+                rj[k] = m_threadBuffer[thread].m_r[k].data();
+
+            for (uint32_t n = m_cellStart[cell]; n < m_cellStart[cell + 1]; ++n)
+            {
+                size_t i = m_order[n];
+
+                // ghosts only act on own particles
+                if (i >= m_owned)
+                    continue;
+
+                double ri[Dim];
+                double fi[Dim] = {};
+                double pot_i   = 0;
+
+                for (size_t k = 0; k < Dim; ++k)
+                    ri[k] = m_r[k][i];
+
+                for (size_t jb = 0; jb < count; jb += m_rowSize)
+                {
+                    size_t nj = std::min(m_rowSize, count - jb);
+
+                    // row of pair forces is stored, not summed, so that the loop has no reductions
+                    double row_f[Dim][m_rowSize], row_pot[m_rowSize];
+
+                    for (size_t j = 0; j < nj; ++j)
+                    {
+                        double d[Dim];
+                        double r2 = 0;
+
+                        for (size_t k = 0; k < Dim; ++k)
+                        {
+                            d[k] = Physics::minimum_image(rj[k][jb + j] - ri[k], period[k], inv_period[k]);
+                            r2  += d[k] * d[k];
+                        }
+
+                        // 1 for rmin2 < r2 < rc2 and 0 otherwise, so the particle itself and the pairs
+                        // beyond the cutoff are masked out without branches and the loop vectorizes
+                        double inside = 0.5 + std::copysign(0.5, half - std::abs(r2 - middle));
+                        double p;
+                        double f = Physics::lennard_jones(std::max(r2, rmin2), p) * inside;
+
+                        row_pot[j] = (p - shift) * inside;
+
+                        for (size_t k = 0; k < Dim; ++k)
+                            row_f[k][j] = f * d[k];
+                    }
+
+                    for (size_t j = 0; j < nj; ++j)
+                    {
+                        for (size_t k = 0; k < Dim; ++k)
+                            fi[k] += row_f[k][j];
+
+                        pot_i += row_pot[j];
+                    }
+                }
+
+                for (size_t k = 0; k < Dim; ++k)
+                    m_a[k][i] = fi[k] / m_m;
+
+                potential_energy += pot_i / 2;
+            }
+        }
+
+        m_threadSum[thread * m_stride] += potential_energy;
+    };
+
+    if (m_numa)
+    {
+        // cells of the atoms of the thread, atoms are ordered by cells after reordering
+        m_pool->StaticFor(0, m_size, [&](size_t first, size_t last, size_t thread)
+        {
+            auto cell_first = std::lower_bound(m_cellStart.begin(), m_cellStart.end(), uint32_t(first));
+            auto cell_last  = std::lower_bound(m_cellStart.begin(), m_cellStart.end(), uint32_t(last));
+
+            cells_forces(cell_first - m_cellStart.begin(), cell_last - m_cellStart.begin(), thread);
+        });
+    }
+    else
+    {
+        m_pool->ParallelFor(0, m_cellFill.size(), cells_forces);
+    }
+
+    double potential_energy = 0;
+
+    for (size_t t = 0; t < m_threadSum.size(); t += m_stride)
+        potential_energy += m_threadSum[t];
+
+    return potential_energy;
+}
+
+// instantiated by the core library, see the end of evaporation.h
+#ifdef EVAPORATION_CORE
+extern template void LargeSystem<2>::Process(uint32_t);
+extern template void LargeSystem<2>::Process();
+extern template void LargeSystem<3>::Process(uint32_t);
+extern template void LargeSystem<3>::Process();
+extern template double LargeSystem<2>::forces();
+extern template double LargeSystem<3>::forces();
+#endif
+
+#endif    // LARGE_SYSTEM_H
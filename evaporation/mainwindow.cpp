@@ -1,6 +1,8 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
-#include <thread>
+#include <QFileDialog>
+#include <limits>
+#include <type_traits>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -8,16 +10,38 @@ MainWindow::MainWindow(QWidget *parent)
 {
     ui->setupUi(this);
 
-    pE.resize(numOfPlotPoints);
-    kE.resize(numOfPlotPoints);
-    e.resize(numOfPlotPoints);
-    ind.resize(numOfPlotPoints);
+    // graphs and labels are set once, frames only update data
+    ui->widget_2->yAxis->setLabel("Кинетическая\n энергия, эВ");
+    ui->widget_3->yAxis->setLabel("Потенциальная\n энергия, эВ");
+    ui->widget_4->yAxis->setLabel("Полная энергия, эВ");
 
-    std::iota(ind.begin(), ind.end(), 0);
+    for (auto plot : {ui->widget_2, ui->widget_3, ui->widget_4})
+    {
+        plot->yAxis->setLabelFont(QFont("Arial", 8));
+        plot->xAxis->setRange(0, numOfPlotPoints - 1);
+        plot->addGraph();
+    }
+
+    ui->widget_2->graph(0)->setData(kEData);
+    ui->widget_3->graph(0)->setData(pEData);
+    ui->widget_4->graph(0)->setData(eData);
 
     draw_energy(ui->widget_2, ui->widget_3, ui->widget_4, m);
 
-    ui->widget->addGraph();
+    // line style of particles does not change, frames only update points;
+    // a curve keeps points in the order of atoms, a graph would need them sorted by x
+    particles = new QCPCurve(ui->widget->xAxis, ui->widget->yAxis);
+    particles->setLineStyle(QCPCurve::lsNone);
+    particles->setData(particlesData);
+
+    // large models are drawn as an image of density over the same area, hidden until needed
+    densityMap = new QCPColorMap(ui->widget->xAxis, ui->widget->yAxis);
+    densityMap->data()->setSize(int(density.GetWidth()), int(density.GetHeight()));
+    densityMap->setGradient(QCPColorGradient::gpThermal);
+    densityMap->setInterpolate(false);
+    densityMap->setVisible(false);
+
+    set_modeling_area();
 
     m.SetTemperature(ui->DoubleSpinBox_3->value());
     m.SetInitialConditions(ui->spinBox_2->value(), ui->spinBox_2->value(), ui->DoubleSpinBox->value() * m.GetEquilibriumDistance());
@@ -26,85 +50,231 @@ MainWindow::MainWindow(QWidget *parent)
 
     draw_timer.setInterval(1000 / 30);
     connect(&draw_timer, SIGNAL(timeout()), this, SLOT(timer_event()));
+
+    create_performance_panel();
+
+    // recordings of live runs are replayed through the same drawing as the model
+    auto trajectoryMenu = ui->menubar->addMenu("Траектория");
+
+    recordAction = trajectoryMenu->addAction("Записывать прогоны");
+    recordAction->setCheckable(true);
+
+    connect(recordAction, &QAction::toggled, this, [this](bool checked)
+    {
+        if (!checked || !recordPath.isEmpty())
+            return;
+
+        recordPath = QFileDialog::getSaveFileName(this, "Файл записи", QString(), "Траектории (*.trj)");
+
+        if (recordPath.isEmpty())
+            recordAction->setChecked(false);
+    });
+
+    connect(trajectoryMenu->addAction("Открыть запись..."), &QAction::triggered, this, [this]
+    {
+        QString path = QFileDialog::getOpenFileName(this, "Открыть запись", QString(), "Траектории (*.trj)");
+
+        if (path.isEmpty())
+            return;
+
+        if (ui->pushButton->isChecked())
+        {
+            ui->pushButton->setChecked(false);
+            on_pushButton_clicked(false);
+        }
+
+        open_replay(path);
+    });
+
+    // controls are copied to the scheduler and atomics when they change, the model thread never reads widgets
+    scheduler.SetRate(ui->SpinBox_3->value());
+    scheduler.SetBatch(iterStep);
+    scheduler.SetFrameBudget(1. / 30);
+    scheduler.SetMode(ScheduleMode(ui->comboBox->currentIndex()));
+    averagingSteps = ui->spinBox->value();
+
+    connect(ui->SpinBox_3, QOverload<int>::of(&QSpinBox::valueChanged), this, [this](int rate) { scheduler.SetRate(rate); });
+    connect(ui->spinBox, QOverload<int>::of(&QSpinBox::valueChanged), this, [this](int steps) { averagingSteps = steps; });
+    connect(ui->comboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int mode)
+    {
+        scheduler.SetMode(ScheduleMode(mode));
+        ui->SpinBox_3->setEnabled(ScheduleMode(mode) == ScheduleMode::TargetRate);
+    });
 }
 
 MainWindow::~MainWindow()
 {
+    scheduler.Stop();
+    densityJob.waitForFinished();
     delete ui;
 }
 
-void MainWindow::draw_particles(QCustomPlot* p, Model& m)
+template <typename Source>
+void MainWindow::draw_particles(QCustomPlot* p, Source& source)
 {
-    p->xAxis->setRange(0, 30);
-    p->yAxis->setRange(0, 30);
+    // snapshot is read without copying and locking the model or the replay
+    auto view = source.ObserveParticlePositions();
 
-    p->xAxis->setLabel(QString("Итерация: " + QString::number(m.GetIteration()) + ". Вылетевшие атомы: " + QString::number(numOfLoss) + ". T: " + QString::number(temprature) + " K"));
+    snapshotLatency = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - view.GetPublicationTime()).count();
 
-    auto [x_, y_] = m.GetParticlePositions();
+    int n = int(view.size());
 
-    QVector<double> x(x_.size());
-    QVector<double> y(y_.size());
+    if (n > densityThreshold)
+    {
+        draw_density(p, source);
+        return;
+    }
 
-    std::copy(x_.begin(),x_.end(),x.begin());
-    std::copy(y_.begin(),y_.end(),y.begin());
-//    QVector<double> x(x_.begin(), x_.end());
-//    QVector<double> y(y_.begin(), y_.end());
+    if (densityMap->visible())
+    {
+        densityMap->setVisible(false);
+        particles->setVisible(true);
+    }
 
-    for (auto i = 0; i < x.size(); ++i)
+    // the curve shares the container, points are written in place and sorted by the index of atom
+    if (particlesData->size() != n)
     {
-        x[i] /= m.GetEquilibriumDistance();
-        y[i] /= m.GetEquilibriumDistance();
+        QVector<QCPCurveData> points(n);
+
+        for (auto i = 0; i < n; ++i)
+            points[i].t = i;
+
+        particlesData->set(points, true);
     }
 
-    double w = p->xAxis->range().size();
-    double h = p->yAxis->range().size();
+    double scale = 1 / m.GetEquilibriumDistance();
+    auto   point = particlesData->begin();
 
-    double scr_w = p->rect().width();
-    double scr_h = p->rect().height();
+    for (auto i = 0; i < n; ++i, ++point)
+    {
+        point->key   = view[0][i] * scale;
+        point->value = view[1][i] * scale;
+    }
+
+    // torn frame, its points are replaced by the next one
+    if (!view.IsValid())
+        return;
 
-    double particle_pixel_radius = 1 * scr_w / w;
-    auto g = p->graph(0);
+    set_particles_label(p, view.GetIteration(), std::is_same<Source, Model>::value);
 
-    g->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssCircle, particle_pixel_radius));
-    g->setLineStyle(QCPGraph::lsNone);
-    g->setData(x,y,true);
+    // scatter size of a particle is one equilibrium distance in pixels
+    double radius = 1 * p->rect().width() / p->xAxis->range().size();
+
+    if (radius != particleRadius)
+    {
+        particleRadius = radius;
+        particles->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssCircle, particleRadius));
+    }
 
     p->replot();
 }
 
-void MainWindow::start_simulation(bool& running)
+template <typename Source>
+void MainWindow::draw_density(QCustomPlot* p, Source& source)
 {
-    while (running)
+    if (!densityMap->visible())
     {
-        std::chrono::system_clock clk;
+        densityMap->setVisible(true);
+        particles->setVisible(false);
+    }
 
-        std::chrono::milliseconds period(1000 * iterStep/ ui->SpinBox_3->value());
+    // the timer does not wait for binning, the last image stays on the screen meanwhile
+    if (densityPending)
+    {
+        if (!densityJob.isFinished())
+            return;
 
-        auto tp1 = clk.now();
+        auto data = densityMap->data();
 
-        m.Process(iterStep);
-        numOfLoss = m.GetParticlesLoss();
+        for (size_t y = 0; y < density.GetHeight(); ++y)
+            for (size_t x = 0; x < density.GetWidth(); ++x)
+                data->setCell(int(x), int(y), density.GetCount(x, y));
 
-        counterMean += iterStep;
+        densityMap->rescaleDataRange(true);
+        set_particles_label(p, densityIteration, std::is_same<Source, Model>::value);
+        p->replot();
 
-        if ( !isStarted )
-           isStarted = true;
+        densityPending = false;
+    }
 
-        if (counterMean >= ui->spinBox->value())
+    // particles are binned by threads of the map while the GUI thread goes on
+    densityJob = QtConcurrent::run([this, &source]
+    {
+        while (true)
         {
-            counterMean = 0;
+            auto view = source.ObserveParticlePositions();
 
-            peVal      = m.GetPotentialEnergySum() / iterStep / 1.6E-19;
-            keVal      = m.GetKineticEnergySum() / iterStep / 1.6E-19;
-            eVal       = peVal + keVal;
+            density.Compute({ view[0], view[1] });
+            densityIteration = view.GetIteration();
 
-            if (m.GetIteration() > 500)
-                temprature = m.GetMeanTemperature();
+            // torn snapshot, it is binned again from a newer one
+            if (view.IsValid())
+                break;
         }
+    });
+
+    densityPending = true;
+}
+
+void MainWindow::set_modeling_area()
+{
+    // the lattice is centred in the area, twice its size leaves room for evaporated atoms
+    double side   = std::max(30., 2 * ui->spinBox_2->value() * ui->DoubleSpinBox->value());
+    double eqDist = m.GetEquilibriumDistance();
+
+    m.SetModelingSpace(side * eqDist, side * eqDist);
+    density.SetArea(0, 0, side * eqDist, side * eqDist);
+
+    ui->widget->xAxis->setRange(0, side);
+    ui->widget->yAxis->setRange(0, side);
 
-        auto tp2 = clk.now();
+    // ranges of color map data are centers of the outer cells
+    double cellX = side / density.GetWidth(), cellY = side / density.GetHeight();
 
-        std::this_thread::sleep_for(period - (tp2 - tp1));
+    densityMap->data()->setRange(QCPRange(cellX / 2, side - cellX / 2), QCPRange(cellY / 2, side - cellY / 2));
+}
+
+void MainWindow::set_particles_label(QCustomPlot* p, uint32_t iteration, bool live)
+{
+    QString label = "Итерация: " + QString::number(iteration);
+
+    // loss and temperature belong to the live run, frames of a recording have only iterations
+    if (live)
+        label += ". Вылетевшие атомы: " + QString::number(numOfLoss.load()) + ". T: " + QString::number(temprature.load()) + " K";
+    else
+        label += " (запись)";
+
+    if (label != particlesLabel)
+    {
+        particlesLabel = label;
+        p->xAxis->setLabel(particlesLabel);
+    }
+}
+
+void MainWindow::on_batch(uint32_t iterations)
+{
+    // called on the thread of the scheduler, widgets are not touched here
+    if (recorder)
+        recorder->Record(m);
+
+    numOfLoss = m.GetParticlesLoss();
+
+    counterMean += iterations;
+
+    if ( !isStarted )
+       isStarted = true;
+
+    if (counterMean >= averagingSteps)
+    {
+        // sums of energies are kept by the model since the previous reading
+        peVal      = m.GetPotentialEnergySum() / counterMean / 1.6E-19;
+        keVal      = m.GetKineticEnergySum() / counterMean / 1.6E-19;
+        eVal       = peVal + keVal;
+
+        counterMean = 0;
+
+        if (m.GetIteration() > 500)
+            temprature = m.GetMeanTemperature();
     }
 }
 
@@ -116,65 +286,54 @@ void MainWindow::on_pushButton_toggled(bool checked)
 void MainWindow::draw_energy(QCustomPlot* kEPlot, QCustomPlot* pEPlot,
                              QCustomPlot* ePlot, Model& m)
 {
-    if (isStarted && !isScaled)
+    // values are sampled once per frame while the model runs, the oldest ones are dropped
+    if (isStarted)
     {
-        pE = QVector<double>(numOfPlotPoints, peVal);
-        kE = QVector<double>(numOfPlotPoints, keVal);
-        e  = QVector<double>(numOfPlotPoints, eVal);
-
-        isScaled = true;
+        kE.Push(keVal);
+        pE.Push(peVal);
+        e.Push(eVal);
     }
 
-    if (curIdPlot < numOfPlotPoints)
-    {
-        pE[curIdPlot] = peVal;
-        kE[curIdPlot] = keVal;
-        e[curIdPlot]  = eVal;
+    double minE =  std::numeric_limits<double>::infinity();
+    double maxE = -std::numeric_limits<double>::infinity();
 
-        ++curIdPlot;
-    }
-    else
+    // graphs share containers with the window, points are written in place from the oldest value
+    for (auto channel : {std::make_pair(&kE, kEData), std::make_pair(&pE, pEData), std::make_pair(&e, eData)})
     {
-        pE = QVector<double>(numOfPlotPoints, 0);
-        kE = QVector<double>(numOfPlotPoints, 0);
-        e  = QVector<double>(numOfPlotPoints, 0);
-        curIdPlot = 0;
+        auto& values = *channel.first;
+        auto& data   = channel.second;
+        int   n      = int(values.size());
 
-        pE[curIdPlot] = peVal;
-        kE[curIdPlot] = keVal;
-        e[curIdPlot]  = eVal;
-        ++curIdPlot;
-        isScaled = false;
-    }
+        if (data->size() != n)
+            data->set(QVector<QCPGraphData>(n), true);
 
-    kEPlot->yAxis->setLabel("Кинетическая\n энергия, эВ");
-    kEPlot->yAxis->setLabelFont(QFont("Arial", 8));
-    kEPlot->addGraph();
-    kEPlot->graph(0)->setData(ind, kE);
-    kEPlot->rescaleAxes();
+        auto point = data->begin();
 
-    pEPlot->yAxis->setLabel("Потенциальная\n энергия, эВ");
-    pEPlot->yAxis->setLabelFont(QFont("Arial", 8));
-    pEPlot->addGraph();
-    pEPlot->graph(0)->setData(ind, pE);
-    pEPlot->rescaleAxes();
+        for (auto i = 0; i < n; ++i, ++point)
+        {
+            point->key   = i;
+            point->value = values[i];
 
-    ePlot->yAxis->setLabel("Полная энергия, эВ");
-    ePlot->yAxis->setLabelFont(QFont("Arial", 8));
-    ePlot->addGraph();
-    ePlot->graph(0)->setData(ind, e);
-    ePlot->rescaleAxes();
+            minE = std::min(minE, point->value);
+            maxE = std::max(maxE, point->value);
+        }
+    }
 
-    auto r1 = kEPlot->yAxis->range();
-    auto r2 = pEPlot->yAxis->range();
-    auto r3 = ePlot->yAxis->range();
+    // all plots share one value range, axes are touched only when the extent of values changes
+    if (minE <= maxE)
+    {
+        QCPRange range(minE, maxE);
 
-    auto max_r = std::max({r1.upper,r2.upper,r3.upper});
-    auto min_r = std::min({r1.lower,r2.lower,r3.lower});
+        if (minE == maxE)
+            range = QCPRange(minE - 0.5, maxE + 0.5);
 
-    kEPlot->yAxis->setRange(min_r,max_r);
-    pEPlot->yAxis->setRange(min_r,max_r);
-    ePlot->yAxis->setRange(min_r,max_r);
+        if (range != kEPlot->yAxis->range())
+        {
+            kEPlot->yAxis->setRange(range);
+            pEPlot->yAxis->setRange(range);
+            ePlot->yAxis->setRange(range);
+        }
+    }
 
     kEPlot->replot();
     pEPlot->replot();
@@ -184,48 +343,268 @@ void MainWindow::draw_energy(QCustomPlot* kEPlot, QCustomPlot* pEPlot,
 
 void MainWindow::on_pushButton_clicked(bool checked)
 {
-    static QFuture<void> future;
-    static QTimer sim_timer;
-    sim_timer.setSingleShot(true);
-
-    static bool running = true;
-
-
-
     if (checked)
     {
-        running = true;
+        // binning may still read the snapshots which the new particles resize
+        densityJob.waitForFinished();
+
+        set_modeling_area();
 
         m.SetTemperature(ui->DoubleSpinBox_3->value());
         m.SetInitialConditions(ui->spinBox_2->value(), ui->spinBox_2->value() ,ui->DoubleSpinBox->value()* m.GetEquilibriumDistance());
         m.EvaluateTimeStep(ui->DoubleSpinBox_2->value());
         ui->pushButton->setText("Стоп");
-        future = QtConcurrent::run([&]{start_simulation(running);});
-        draw_timer.start();
 
-        // sim_timer.singleShot(0,[&]{start_simulation();});
-        // start_simulation();
+        // playback gives the plot to the live run
+        if (ui->pushButton_3->isChecked())
+        {
+            ui->pushButton_3->setChecked(false);
+            on_pushButton_3_clicked(false);
+        }
+
+        ui->pushButton_3->setEnabled(false);
+        ui->horizontalSlider->setEnabled(false);
+
+        if (recordAction->isChecked())
+        {
+            // the file of the previous recording is rewritten
+            replay.reset();
+
+            recorder.reset(new TrajectoryWriter<2>(recordPath.toLocal8Bit().toStdString(), 1E-3, m.GetEquilibriumDistance(), 1));
+            recorder->Record(m);
+        }
+
+        for (auto& values : perfValues)
+            values.Clear();
+
+        perfCounters = m.GetPerformanceCounters();
+        perfTime     = std::chrono::steady_clock::now();
+
+        scheduler.Start();
+        draw_timer.start();
     }
     else
     {
-        running = false;
+        scheduler.Stop();
         draw_timer.stop();
+
+        // the finished recording is opened for replay at once
+        if (recorder)
+        {
+            recorder.reset();
+            open_replay(recordPath);
+        }
+        else if (replay)
+        {
+            ui->pushButton_3->setEnabled(true);
+            ui->horizontalSlider->setEnabled(true);
+        }
+
         ui->pushButton->setText("Старт");
-        future.waitForFinished();
-        pE = QVector<double>(numOfPlotPoints, 0);
-        kE = QVector<double>(numOfPlotPoints, 0);
-        e  = QVector<double>(numOfPlotPoints, 0);
+        pE.Clear();
+        kE.Clear();
+        e.Clear();
         temprature = 0;
-        curIdPlot  = 0;
         counterMean = 0;
         isStarted = false;
-        isScaled = false;
     }
 }
 
 void MainWindow::timer_event()
 {
-    draw_particles(ui->widget, m);
-    draw_energy(ui->widget_2, ui->widget_3, ui->widget_4, m);
+    auto begin = std::chrono::steady_clock::now();
+
+    if (ui->pushButton_3->isChecked())
+        draw_replay();
+    else
+    {
+        draw_particles(ui->widget, m);
+        draw_energy(ui->widget_2, ui->widget_3, ui->widget_4, m);
+
+        ui->statusbar->showMessage("Скорость: " + QString::number(scheduler.GetAchievedRate(), 'f', 0) + " шагов в секунду. Шагов за кадр: " + QString::number(scheduler.GetBatch()));
+    }
+
+    draw_performance();
+
+    // shown by the next frame
+    frameTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
+
+
+void MainWindow::create_performance_panel()
+{
+    const QStringList titles = {"Итераций в секунду", "нс на атом за шаг", "Пар за шаг",
+                                "Ожидание мьютекса, %", "Задержка снимка, мс", "Время кадра, мс"};
+
+    perfDock = new QDockWidget("Производительность", this);
+    perfPlot = new QCustomPlot(perfDock);
+    perfDock->setWidget(perfPlot);
+    addDockWidget(Qt::RightDockWidgetArea, perfDock);
+
+    // widgets of the window have fixed geometry, so the panel floats over them and is opened from the menu
+    perfDock->setFloating(true);
+    perfDock->resize(700, 600);
+    perfDock->hide();
+    ui->menubar->addMenu("Вид")->addAction(perfDock->toggleViewAction());
+
+    perfPlot->plotLayout()->clear();
+
+    for (int i = 0; i < titles.size(); ++i)
+    {
+        auto rect = new QCPAxisRect(perfPlot);
+
+        perfPlot->plotLayout()->addElement(i / 2, i % 2, rect);
+        rect->axis(QCPAxis::atBottom)->setRange(0, numOfPlotPoints - 1);
+        rect->axis(QCPAxis::atLeft)->setLabel(titles[i]);
+        rect->axis(QCPAxis::atLeft)->setLabelFont(QFont("Arial", 8));
+
+        perfValues.emplace_back(size_t(numOfPlotPoints));
+        perfData.emplace_back(new QCPGraphDataContainer);
+
+        perfPlot->addGraph(rect->axis(QCPAxis::atBottom), rect->axis(QCPAxis::atLeft))->setData(perfData.back());
+    }
+}
+
+void MainWindow::draw_performance()
+{
+    auto   counters = m.GetPerformanceCounters();
+    auto   now      = std::chrono::steady_clock::now();
+    double seconds  = std::chrono::duration<double>(now - perfTime).count();
+    double nan      = std::numeric_limits<double>::quiet_NaN();
+
+    double iterations = double(counters.m_iterations - perfCounters.m_iterations);
+    double steps      = double(counters.m_particleSteps - perfCounters.m_particleSteps);
+    double pairs      = double(counters.m_pairEvaluations - perfCounters.m_pairEvaluations);
+    double process    = double(counters.m_processTime - perfCounters.m_processTime);
+    double wait       = double(counters.m_lockWaitTime - perfCounters.m_lockWaitTime);
+
+    // values per step are undefined for frames without iterations, they are drawn as gaps
+    double values[] = { (seconds > 0) ? iterations / seconds : nan,
+                        (steps > 0) ? process / steps : nan,
+                        (iterations > 0) ? pairs / iterations : nan,
+                        (seconds > 0) ? 100 * wait * 1E-9 / seconds : nan,
+                        snapshotLatency,
+                        frameTime };
+
+    perfCounters = counters;
+    perfTime     = now;
+
+    for (size_t i = 0; i < perfValues.size(); ++i)
+        perfValues[i].Push(values[i]);
+
+    // values are kept while the panel is closed, so it opens with the history
+    if (!perfDock->isVisible())
+        return;
+
+    for (size_t i = 0; i < perfValues.size(); ++i)
+    {
+        auto&  buffer = perfValues[i];
+        auto&  data   = perfData[i];
+        int    n      = int(buffer.size());
+        double maxV   = 0;
+
+        if (data->size() != n)
+            data->set(QVector<QCPGraphData>(n), true);
+
+        auto point = data->begin();
+
+        for (auto j = 0; j < n; ++j, ++point)
+        {
+            point->key   = j;
+            point->value = buffer[j];
+
+            if (!std::isnan(point->value))
+                maxV = std::max(maxV, point->value);
+        }
+
+        // the range grows and shrinks in steps, so axes are not touched every frame
+        auto axis = perfPlot->axisRect(int(i))->axis(QCPAxis::atLeft);
+
+        if ((maxV > axis->range().upper) || (maxV < axis->range().upper / 4))
+            axis->setRange(0, (maxV > 0) ? 2 * maxV : 1);
+    }
+
+    perfPlot->replot();
+}
+
+void MainWindow::open_replay(const QString& path)
+{
+    // binning may still read the previous recording
+    densityJob.waitForFinished();
+
+    replay.reset(new TrajectoryReplay<2>(path.toLocal8Bit().toStdString()));
+
+    bool opened = replay->IsValid() && (replay->GetFramesAmount() > 0);
+
+    ui->pushButton_3->setEnabled(opened);
+    ui->horizontalSlider->setEnabled(opened);
+
+    if (!opened)
+    {
+        replay.reset();
+        ui->statusbar->showMessage("Не удалось открыть запись " + path);
+        return;
+    }
+
+    {
+        QSignalBlocker blocker(ui->horizontalSlider);
+
+        ui->horizontalSlider->setRange(0, int(replay->GetFramesAmount()) - 1);
+        ui->horizontalSlider->setValue(0);
+    }
+
+    on_horizontalSlider_valueChanged(0);
 }
 
+void MainWindow::draw_replay()
+{
+    // frames per second of playback are spread over ticks of the timer
+    replayFrames += ui->DoubleSpinBox_4->value() * draw_timer.interval() / 1000.;
+
+    size_t step  = size_t(replayFrames);
+    size_t last  = replay->GetFramesAmount() - 1;
+    size_t frame = std::min(replay->GetFrame() + step, last);
+
+    replayFrames -= step;
+
+    // the slider seeks and draws the frame
+    ui->horizontalSlider->setValue(int(frame));
+
+    if (frame == last)
+    {
+        ui->pushButton_3->setChecked(false);
+        on_pushButton_3_clicked(false);
+    }
+}
+
+void MainWindow::on_pushButton_3_clicked(bool checked)
+{
+    if (checked)
+    {
+        // playback from the last frame starts over
+        if (replay->GetFrame() + 1 >= replay->GetFramesAmount())
+            ui->horizontalSlider->setValue(0);
+
+        replayFrames = 0;
+        ui->pushButton_3->setText("Пауза");
+        draw_timer.start();
+    }
+    else
+    {
+        draw_timer.stop();
+        ui->pushButton_3->setText("Воспроизвести");
+    }
+}
+
+void MainWindow::on_horizontalSlider_valueChanged(int value)
+{
+    if (!replay)
+        return;
+
+    // frames of a recording are decoded from the mapped file, nothing is simulated
+    replay->Seek(size_t(value));
+    draw_particles(ui->widget, *replay);
+
+    ui->statusbar->showMessage("Кадр " + QString::number(value + 1) + " из " + QString::number(replay->GetFramesAmount()) +
+                               ", итерация " + QString::number(replay->GetIteration(size_t(value))));
+}
@@ -1,10 +1,20 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include <QDockWidget>
 #include <QMainWindow>
 #include <QtConcurrent/QtConcurrent>
 #include <qcustomplot.h>
+#include "density_map.h"
 #include "evaporation.h"
+#include "ring_buffer.h"
+#include "simulation_scheduler.h"
+#include "trajectory_codec.h"
+#include "trajectory_replay.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -23,6 +33,8 @@ public:
 private slots:
     void on_pushButton_toggled(bool checked);
     void on_pushButton_clicked(bool checked);
+    void on_pushButton_3_clicked(bool checked);
+    void on_horizontalSlider_valueChanged(int value);
     void timer_event();
 
 private:
@@ -30,29 +42,69 @@ private:
 
     Model m;
 
-    const int iterStep        = 20;
-          int numOfLoss       = 0;
+    const int iterStep        = 20;                 // iterations of a batch in the fixed batch mode
+    std::atomic<int> numOfLoss {0};
 
     const int numOfPlotPoints = 512;
-    int curIdPlot = 0;
-    bool isStarted = false;
-    bool isScaled  = false;
+    std::atomic<bool> isStarted {false};
 
-    void draw_particles(QCustomPlot* g, Model& m);
+    template <typename Source> void draw_particles(QCustomPlot* p, Source& source);
+    template <typename Source> void draw_density(QCustomPlot* p, Source& source);
+    void set_modeling_area();
+    void set_particles_label(QCustomPlot* p, uint32_t iteration, bool live);
     void draw_energy(QCustomPlot* kEPlot, QCustomPlot* pEPlot, QCustomPlot* ePlot, Model& m);
-    void start_simulation(bool& running);
+    void on_batch(uint32_t iterations);
+    void create_performance_panel();
+    void draw_performance();
+    void open_replay(const QString& path);
+    void draw_replay();
 
     QTimer draw_timer;
 
-    QVector<double> pE;
-    QVector<double> kE;
-    QVector<double> e;
-    QVector<double> ind;
+    RingBuffer<double> pE {size_t(numOfPlotPoints)};    // energies of the last frames, oldest first
+    RingBuffer<double> kE {size_t(numOfPlotPoints)};
+    RingBuffer<double> e  {size_t(numOfPlotPoints)};
 
-    double peVal       = 0;
-    double keVal       = 0;
-    double eVal        = 0;
-    double temprature  = 0;
-    int    counterMean = 0;
+    QSharedPointer<QCPGraphDataContainer> kEData {new QCPGraphDataContainer};    // points of energy graphs shared with them
+    QSharedPointer<QCPGraphDataContainer> pEData {new QCPGraphDataContainer};
+    QSharedPointer<QCPGraphDataContainer> eData  {new QCPGraphDataContainer};
+
+    QSharedPointer<QCPCurveDataContainer> particlesData {new QCPCurveDataContainer};    // points of particles shared with the curve
+    QCPCurve*                             particles = nullptr;                        // scatter of particles, owned by the plot
+    QString                               particlesLabel;                             // label of the last frame
+    double                                particleRadius = 0;                         // scatter size of the last frame in pixels
+
+    const int     densityThreshold = 20000;       // particles above which the density map replaces points, side of 142
+    DensityMap    density {256, 256};             // particles binned off the GUI thread
+    QCPColorMap*  densityMap       = nullptr;     // image of density, owned by the plot
+    QFuture<void> densityJob;                     // binning of the last snapshot
+    bool          densityPending   = false;       // binning was started and its image is not shown yet
+    uint32_t      densityIteration = 0;           // iteration of the binned snapshot
+
+    QDockWidget*                                       perfDock = nullptr;    // panel of performance plots, owned by the window
+    QCustomPlot*                                       perfPlot = nullptr;    // one axis rect per metric
+    std::vector<RingBuffer<double>>                    perfValues;            // metrics of the last frames, oldest first
+    std::vector<QSharedPointer<QCPGraphDataContainer>> perfData;              // points of metric graphs shared with them
+    PerformanceCounters                                perfCounters;          // counters of the model at the previous frame
+    std::chrono::steady_clock::time_point              perfTime;              // time of the previous frame
+    double                                             snapshotLatency = 0;   // age of the last drawn snapshot, ms
+    double                                             frameTime       = 0;   // time of drawing the previous frame, ms
+
+    std::unique_ptr<TrajectoryWriter<2>> recorder;               // recording of the live run, written by the scheduler thread
+    std::unique_ptr<TrajectoryReplay<2>> replay;                 // opened recording
+    QAction*                             recordAction = nullptr; // live runs are recorded while checked
+    QString                              recordPath;             // file of recordings
+    double                               replayFrames = 0;       // frames to advance by the next ticks, fractional part is kept
+
+    // written by the thread of the scheduler after batches, read by the timer
+    std::atomic<double> peVal       {0};
+    std::atomic<double> keVal       {0};
+    std::atomic<double> eVal        {0};
+    std::atomic<double> temprature  {0};
+    std::atomic<int>    averagingSteps {100};    // iterations over which T and E are averaged
+    int                 counterMean = 0;         // iterations since the last averaging, used by the scheduler thread
+
+    // declared last, so the thread is stopped before the members it uses are destroyed
+    SimulationScheduler<Model> scheduler {m, [this](uint32_t iterations) { on_batch(iterations); }};
 };
 #endif // MAINWINDOW_H
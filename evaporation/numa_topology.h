@@ -0,0 +1,245 @@
+#ifndef NUMA_TOPOLOGY_H
+#define NUMA_TOPOLOGY_H
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+//*********************************************************************************************************
+// NumaTopology - NUMA nodes of the host read from sysfs and nodes of memory pages
+//*********************************************************************************************************
+// Only Linux is supported, elsewhere the host is seen as one node and pages are not queried.
+// libnuma is not needed, pages are queried by the move_pages system call without moving them.
+//*********************************************************************************************************
+class NumaTopology
+{
+private:    // variables
+
+    std::vector<int> m_cpus;                                                         //!< CPUs allowed to the process ordered by nodes
+    std::vector<int> m_nodeOfCpu;                                                    //!< Node of every CPU by its index
+    int              m_nodes = 1;                                                    //!< Number of nodes with allowed CPUs
+
+public:     // methods
+
+    //*****************************************************************************************************
+    // Constructor - read nodes of CPUs allowed to the process
+    //*****************************************************************************************************
+    NumaTopology()
+    {
+#ifdef __linux__
+        cpu_set_t allowed;
+
+        CPU_ZERO(&allowed);
+
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+            return;
+
+        m_nodes = 0;
+
+        for (int node : read_nodes())
+        {
+            std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+
+            if (!file)
+                continue;
+
+            std::string list;
+            std::getline(file, list);
+
+            bool used = false;
+
+            for (int cpu : parse_list(list))
+            {
+                if ((cpu >= CPU_SETSIZE) || !CPU_ISSET(cpu, &allowed))
+                    continue;
+
+                if (size_t(cpu) >= m_nodeOfCpu.size())
+                    m_nodeOfCpu.resize(cpu + 1, -1);
+
+                m_nodeOfCpu[cpu] = node;
+                m_cpus.push_back(cpu);
+                used = true;
+            }
+
+            m_nodes += used;
+        }
+
+        // no sysfs nodes, all allowed CPUs are on one node
+        if (m_cpus.empty())
+        {
+            m_nodes = 1;
+
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+            {
+                if (!CPU_ISSET(cpu, &allowed))
+                    continue;
+
+                m_nodeOfCpu.resize(cpu + 1, -1);
+                m_nodeOfCpu[cpu] = 0;
+                m_cpus.push_back(cpu);
+            }
+        }
+#endif
+    };
+
+    //*****************************************************************************************************
+    // GetCpus() - get CPUs allowed to the process, CPUs of one node follow each other
+    //*****************************************************************************************************
+    //! @return indices of CPUs
+    //*****************************************************************************************************
+    const std::vector<int>& GetCpus() const
+    {
+        return m_cpus;
+    };
+
+    //*****************************************************************************************************
+    // GetNodesAmount() - get number of nodes with CPUs allowed to the process
+    //*****************************************************************************************************
+    //! @return number of nodes
+    //*****************************************************************************************************
+    int GetNodesAmount() const
+    {
+        return m_nodes;
+    };
+
+    //*****************************************************************************************************
+    // GetNodeOfCpu() - get node of CPU
+    //*****************************************************************************************************
+    //! @param [in] cpu index of CPU
+    //! @return id of node as reported for memory pages, -1 for unknown CPU
+    //*****************************************************************************************************
+    int GetNodeOfCpu(int cpu) const
+    {
+        return ((cpu >= 0) && (size_t(cpu) < m_nodeOfCpu.size())) ? m_nodeOfCpu[cpu] : -1;
+    };
+
+    //*****************************************************************************************************
+    // GetCurrentCpu() - get CPU which runs the calling thread now
+    //*****************************************************************************************************
+    //! @return index of CPU, -1 if not known
+    //*****************************************************************************************************
+    static int GetCurrentCpu()
+    {
+#ifdef __linux__
+        return sched_getcpu();
+#else
+        return -1;
+#endif
+    };
+
+    //*****************************************************************************************************
+    // GetPageNodes() - get nodes of memory pages of a block, pages are not moved
+    //*****************************************************************************************************
+    //! @param [in] data begin of block
+    //! @param [in] bytes size of block
+    //! @param [out] nodes node of every page, negative for pages not touched yet
+    //! @return true if nodes were queried
+    //*****************************************************************************************************
+    static bool GetPageNodes(const void* data, size_t bytes, std::vector<int>& nodes)
+    {
+        nodes.clear();
+
+#if defined(__linux__) && defined(SYS_move_pages)
+        if (bytes == 0)
+            return true;
+
+        uintptr_t page  = uintptr_t(sysconf(_SC_PAGESIZE));
+        uintptr_t first = uintptr_t(data) / page * page;
+        uintptr_t last  = (uintptr_t(data) + bytes - 1) / page * page;
+
+        std::vector<void*> pages;
+
+        for (uintptr_t p = first; p <= last; p += page)
+            pages.push_back(reinterpret_cast<void*>(p));
+
+        nodes.resize(pages.size());
+
+        // without target nodes move_pages() only reports where the pages are
+        return syscall(SYS_move_pages, 0, pages.size(), pages.data(), nullptr, nodes.data(), 0) == 0;
+#else
+        (void)data;
+        (void)bytes;
+
+        return false;
+#endif
+    };
+
+private:    // methods
+
+    //*****************************************************************************************************
+    // read_nodes() - get ids of sysfs nodes, ids may have gaps after offlined nodes
+    //*****************************************************************************************************
+    //! @return ids of nodes in ascending order
+    //*****************************************************************************************************
+    static std::vector<int> read_nodes()
+    {
+        std::vector<int> nodes;
+
+#ifdef __linux__
+        DIR* dir = opendir("/sys/devices/system/node");
+
+        if (dir == nullptr)
+            return nodes;
+
+        while (dirent* entry = readdir(dir))
+        {
+            const char* name = entry->d_name;
+
+            if ((strncmp(name, "node", 4) != 0) || !isdigit(static_cast<unsigned char>(name[4])))
+                continue;
+
+            nodes.push_back(atoi(name + 4));
+        }
+
+        closedir(dir);
+
+        std::sort(nodes.begin(), nodes.end());
+#endif
+
+        return nodes;
+    };
+
+    //*****************************************************************************************************
+    // parse_list() - parse sysfs list of CPUs like "0-3,8-11"
+    //*****************************************************************************************************
+    //! @param [in] list text of list
+    //! @return indices of CPUs
+    //*****************************************************************************************************
+    static std::vector<int> parse_list(const std::string& list)
+    {
+        std::vector<int>  cpus;
+        std::stringstream stream(list);
+        std::string       range;
+
+        while (std::getline(stream, range, ','))
+        {
+            if (range.empty())
+                continue;
+
+            size_t dash  = range.find('-');
+            int    first = std::stoi(range.substr(0, dash));
+            int    last  = (dash == std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+
+            for (int cpu = first; cpu <= last; ++cpu)
+                cpus.push_back(cpu);
+        }
+
+        return cpus;
+    };
+};
+
+#endif    // NUMA_TOPOLOGY_H
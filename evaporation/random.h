@@ -0,0 +1,121 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+//*********************************************************************************************************
+// NormalGenerator - generator of standard normal numbers in blocks
+//*********************************************************************************************************
+// m_lanes independent xoshiro256+ streams are advanced side by side, the state is stored word-major
+// so one update of all streams is a plain loop over lanes and vectorizes. Normal numbers are made
+// from pairs of uniform ones by the Box-Muller transform.
+//*********************************************************************************************************
+class NormalGenerator
+{
+private:    // variables
+
+    constexpr static size_t m_lanes = 4;                                             //!< Number of independent streams
+    uint64_t m_state[4][m_lanes] = {};                                               //!< State word k of stream l at [k][l]
+
+public:     // methods
+
+    //*****************************************************************************************************
+    // Constructor
+    //*****************************************************************************************************
+    //! @param [in, optional] seed value of seed
+    //*****************************************************************************************************
+    explicit NormalGenerator(uint64_t seed = 0x9E3779B97F4A7C15ull)
+    {
+        Seed(seed);
+    };
+
+    //*****************************************************************************************************
+    // Seed() - set state of all streams from one value with splitmix64
+    //*****************************************************************************************************
+    //! @param [in] seed value of seed
+    //*****************************************************************************************************
+    void Seed(uint64_t seed)
+    {
+        for (size_t l = 0; l < m_lanes; ++l)
+        {
+            for (size_t k = 0; k < 4; ++k)
+            {
+                seed += 0x9E3779B97F4A7C15ull;
+
+                uint64_t z = seed;
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+
+                m_state[k][l] = z ^ (z >> 31);
+            }
+        }
+    };
+
+    //*****************************************************************************************************
+    // Fill() - fill array with standard normal numbers
+    //*****************************************************************************************************
+    //! @param [out] out pointer to array
+    //! @param [in] n number of values
+    //*****************************************************************************************************
+    void Fill(double* out, size_t n)
+    {
+        constexpr double two_pi = 2 * 3.14159265358979323;
+
+        size_t i = 0;
+
+        for (; i + 2 * m_lanes <= n; i += 2 * m_lanes)
+        {
+            double u1[m_lanes], u2[m_lanes];
+
+            Uniform(u1);
+            Uniform(u2);
+
+            for (size_t l = 0; l < m_lanes; ++l)
+            {
+                double r = sqrt(-2 * log(1 - u1[l]));
+
+                out[i + l]           = r * cos(two_pi * u2[l]);
+                out[i + m_lanes + l] = r * sin(two_pi * u2[l]);
+            }
+        }
+
+        if (i < n)
+        {
+            double tail[2 * m_lanes];
+
+            Fill(tail, 2 * m_lanes);
+
+            for (size_t k = 0; i < n; ++i, ++k)
+                out[i] = tail[k];
+        }
+    };
+
+private:
+
+    //*****************************************************************************************************
+    // Uniform() - advance all streams and get one uniform number in [0, 1) from each
+    //*****************************************************************************************************
+    //! @param [out] out array of m_lanes values
+    //*****************************************************************************************************
+    void Uniform(double* out)
+    {
+        for (size_t l = 0; l < m_lanes; ++l)
+        {
+            uint64_t result = m_state[0][l] + m_state[3][l];
+            uint64_t t      = m_state[1][l] << 17;
+
+            m_state[2][l] ^= m_state[0][l];
+            m_state[3][l] ^= m_state[1][l];
+            m_state[1][l] ^= m_state[2][l];
+            m_state[0][l] ^= m_state[3][l];
+            m_state[2][l] ^= t;
+            m_state[3][l]  = (m_state[3][l] << 45) | (m_state[3][l] >> 19);
+
+            out[l] = (result >> 11) * 0x1.0p-53;
+        }
+    };
+};
+
+#endif    // RANDOM_H
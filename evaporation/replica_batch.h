@@ -0,0 +1,367 @@
+#ifndef REPLICA_BATCH_H
+#define REPLICA_BATCH_H
+
+#include "evaporation.h"
+#include "statistics.h"
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+//*********************************************************************************************************
+// ReplicaBatch - W independent replicas of the same size advanced together
+//*********************************************************************************************************
+// Every array is stored replica-major: value of particle i in replica l lives at [i * W + l].
+// All loops over replicas are innermost, so each SIMD lane works on its own replica and
+// the force loop vectorizes regardless of the cluster size. Physics is the same as in Model.
+//*********************************************************************************************************
+template <size_t W>
+class ReplicaBatch
+{
+public:     // types
+
+    using LaneValues = std::array<double, W>;                                        //!< One value per replica
+
+private:    // variables
+
+    size_t              m_size      = 0;                                             //!< Number of particles in every replica
+
+    std::vector<double> m_x;                                                         //!< x coordinates
+    std::vector<double> m_y;                                                         //!< y coordinates
+    std::vector<double> m_vX;                                                        //!< x velocities
+    std::vector<double> m_vY;                                                        //!< y velocities
+    std::vector<double> m_aX;                                                        //!< Current x accelerations
+    std::vector<double> m_aY;                                                        //!< Current y accelerations
+    std::vector<double> m_aX_previous;                                               //!< Previous x accelerations
+    std::vector<double> m_aY_previous;                                               //!< Previous y accelerations
+
+    double    m_spaceLeft   = 0;                                                     //!< Position of the left wall of the modeling area
+    double    m_spaceRight  = 30 * Model::m_equilibrium_distance;                    //!< Position of the right wall of the modeling area
+    double    m_spaceTop    = 30 * Model::m_equilibrium_distance;                    //!< Position of the top wall of the modeling area
+    double    m_spaceBot    = 0;                                                     //!< Position of the bot wall of the modeling area
+
+    uint32_t  m_iter        = 0;                                                     //!< Current value of iterations
+    double    m_timestep    = 0;                                                     //!< Time step of modeling
+    double    m_temp        = 1;                                                     //!< Init temprature in K
+    LaneValues m_kESum      = {};                                                    //!< Kinetic energy sum of every replica
+    LaneValues m_pESum      = {};                                                    //!< Potencial energy sum of every replica
+
+    std::array<BlockAverage, W> m_temperatureStats;                                  //!< Temperature of every iteration of every replica
+
+    std::mt19937_64 m_gen{std::random_device{}()};                                   //!< Generator for initial velocities
+
+public:     // methods
+
+    //*****************************************************************************************************
+    // SetTemperature() - set initial temperature in K
+    //*****************************************************************************************************
+    //! @param [in] t value of init temperature in K
+    //*****************************************************************************************************
+    void SetTemperature(double t)
+    {
+        if (t >= 0)
+            m_temp = t;
+    };
+
+    //*****************************************************************************************************
+    // SetSeed() - seed generator of initial velocities
+    //*****************************************************************************************************
+    //! @param [in] seed value of seed
+    //*****************************************************************************************************
+    void SetSeed(uint64_t seed)
+    {
+        m_gen.seed(seed);
+    };
+
+    //*****************************************************************************************************
+    // EvaluateTimeStep() - evaluate time step funtion, same as Model::EvaluateTimeStep()
+    //*****************************************************************************************************
+    //! @param [in, optional] factor value of factor of time step for adjustment
+    //*****************************************************************************************************
+    double EvaluateTimeStep(double factor = 0.01)
+    {
+        if (factor <= 0)
+            factor = 0.01;
+
+        m_timestep = factor * sqrt(Particle::m_m * Model::m_equilibrium_distance *
+                                   Model::m_equilibrium_distance / Model::m_depth);
+
+        return m_timestep;
+    };
+
+    //*****************************************************************************************************
+    // SetInitialConditions() - set initial grid and velocities of every replica
+    //*****************************************************************************************************
+    //! @param [in] width number of segments along the y axis into which the grid is divided
+    //! @param [in] height number of segments along the x axis into which the grid is divided
+    //! @param [in] periods period of grid for every replica
+    //*****************************************************************************************************
+    void SetInitialConditions(int width, int height, const LaneValues& periods)
+    {
+        if ((width <= 1) || (height <= 1))
+            return;
+
+        m_iter = 0;
+        m_size = width * height;
+        m_kESum.fill(0);
+        m_pESum.fill(0);
+        ResetStatistics();
+
+        for (auto v : {&m_x, &m_y, &m_vX, &m_vY, &m_aX, &m_aY, &m_aX_previous, &m_aY_previous})
+            v->assign(m_size * W, 0.0);
+
+        double center_x = (m_spaceRight - m_spaceLeft) / 2.;
+        double center_y = (m_spaceTop - m_spaceBot) / 2.;
+
+        int leftX = - height / 2;
+        int leftY = - width / 2;
+
+        for (size_t i = 0; i < m_size; ++i)
+        {
+            for (size_t l = 0; l < W; ++l)
+            {
+                m_x[i * W + l] = center_x + (leftX + int(i) / width) * periods[l];
+                m_y[i * W + l] = center_y + (leftY + int(i) % width) * periods[l];
+            }
+        }
+
+        SetInitialVelocities();
+
+        if (m_timestep == 0)
+            EvaluateTimeStep();
+    };
+
+    //*****************************************************************************************************
+    // Process() - process some iterations of modeling for all replicas
+    //*****************************************************************************************************
+    //! @param [in] iterations value of iterations to process
+    //*****************************************************************************************************
+    void Process(uint32_t iterations)
+    {
+        for (uint32_t i = 0; i < iterations; ++i)
+            Process();
+    };
+
+    //*****************************************************************************************************
+    // Process() - process one iteration of modeling for all replicas
+    //*****************************************************************************************************
+    void Process()
+    {
+        const size_t n  = m_size * W;
+        const double dt = m_timestep;
+
+        for (size_t k = 0; k < n; ++k)
+        {
+            m_aX_previous[k] = m_aX[k];
+            m_aY_previous[k] = m_aY[k];
+            m_aX[k] = 0.0;
+            m_aY[k] = 0.0;
+
+            m_x[k] += m_vX[k] * dt + m_aX_previous[k] * dt * dt / 2.0;
+            m_y[k] += m_vY[k] * dt + m_aY_previous[k] * dt * dt / 2.0;
+        }
+
+        double pe[W] = {};
+
+        for (size_t i = 0; i + 1 < m_size; ++i)
+        {
+            const double* xi = &m_x[i * W];
+            const double* yi = &m_y[i * W];
+            double fxi[W] = {}, fyi[W] = {};
+
+            for (size_t j = i + 1; j < m_size; ++j)
+            {
+                const double* xj  = &m_x[j * W];
+                const double* yj  = &m_y[j * W];
+                double*       axj = &m_aX[j * W];
+                double*       ayj = &m_aY[j * W];
+
+                for (size_t l = 0; l < W; ++l)
+                {
+                    double dx = xj[l] - xi[l];
+                    double dy = yj[l] - yi[l];
+                    double pot;
+                    double f  = Model::lennard_jones(dx * dx + dy * dy, pot);
+
+                    fxi[l] += f * dx;
+                    fyi[l] += f * dy;
+                    axj[l] -= f * dx;
+                    ayj[l] -= f * dy;
+                    pe[l]  += pot;
+                }
+            }
+
+            for (size_t l = 0; l < W; ++l)
+            {
+                m_aX[i * W + l] += fxi[l];
+                m_aY[i * W + l] += fyi[l];
+            }
+        }
+
+        double ke[W] = {};
+
+        for (size_t i = 0; i < m_size; ++i)
+        {
+            for (size_t l = 0; l < W; ++l)
+            {
+                size_t k = i * W + l;
+
+                m_aX[k] /= Particle::m_m;
+                m_aY[k] /= Particle::m_m;
+
+                m_vX[k] += dt * (m_aX[k] + m_aX_previous[k]) / 2.0;
+                m_vY[k] += dt * (m_aY[k] + m_aY_previous[k]) / 2.0;
+
+                ke[l] += Particle::m_m * (m_vX[k] * m_vX[k] + m_vY[k] * m_vY[k]) / 2.;
+            }
+        }
+
+        for (size_t l = 0; l < W; ++l)
+        {
+            m_pESum[l] += pe[l];
+            m_kESum[l] += ke[l];
+
+            m_temperatureStats[l].Add(ke[l] / (m_size * Model::m_boltzman));
+        }
+
+        ++m_iter;
+    };
+
+    //*****************************************************************************************************
+    // GetKineticEnergySum() - get kinetic energy sums and set them as zero
+    //*****************************************************************************************************
+    //! @return kinetic energy sum of every replica
+    //*****************************************************************************************************
+    LaneValues GetKineticEnergySum()
+    {
+        LaneValues ke = m_kESum;
+        m_kESum.fill(0);
+
+        return ke;
+    };
+
+    //*****************************************************************************************************
+    // GetPotentialEnergySum() - get potential energy sums and set them as zero
+    //*****************************************************************************************************
+    //! @return potential energy sum of every replica
+    //*****************************************************************************************************
+    LaneValues GetPotentialEnergySum()
+    {
+        LaneValues pe = m_pESum;
+        m_pESum.fill(0);
+
+        return pe;
+    };
+
+    //*****************************************************************************************************
+    // ResetStatistics() - forget statistics of every replica, f.e. at the end of equilibration
+    //*****************************************************************************************************
+    void ResetStatistics()
+    {
+        for (auto& stats : m_temperatureStats)
+            stats.Reset();
+    };
+
+    //*****************************************************************************************************
+    // GetTemperatureStatistics() - get statistics of temperature in K of one replica since the last reset
+    //*****************************************************************************************************
+    //! @param [in] lane index of replica
+    //! @return mean and error bar of temperature
+    //*****************************************************************************************************
+    const BlockAverage& GetTemperatureStatistics(size_t lane) const
+    {
+        return m_temperatureStats[lane];
+    };
+
+    //*****************************************************************************************************
+    // GetParticlesLoss() - get number of particles out of modeling space in every replica
+    //*****************************************************************************************************
+    //! @return number of lost particles of every replica
+    //*****************************************************************************************************
+    std::array<uint32_t, W> GetParticlesLoss() const
+    {
+        std::array<uint32_t, W> loss = {};
+
+        for (size_t i = 0; i < m_size; ++i)
+        {
+            for (size_t l = 0; l < W; ++l)
+            {
+                double x = m_x[i * W + l];
+                double y = m_y[i * W + l];
+
+                loss[l] += (x < m_spaceLeft) || (x > m_spaceRight) ||
+                           (y < m_spaceBot)  || (y > m_spaceTop);
+            }
+        }
+
+        return loss;
+    };
+
+    //*****************************************************************************************************
+    // GetIteration() - get cur value of iteration function
+    //*****************************************************************************************************
+    //! @return value of cur iteration
+    //*****************************************************************************************************
+    uint32_t GetIteration() const
+    {
+        return m_iter;
+    };
+
+    //*****************************************************************************************************
+    // GetParticlesAmount() - get number of particles in one replica
+    //*****************************************************************************************************
+    //! @return number of particles
+    //*****************************************************************************************************
+    uint32_t GetParticlesAmount() const
+    {
+        return m_size;
+    };
+
+private:
+
+    //*****************************************************************************************************
+    // SetInitialVelocities() - random directions with module set by m_temp and zero total momentum
+    //*****************************************************************************************************
+    void SetInitialVelocities()
+    {
+        double V = sqrt(Model::m_boltzman * m_temp / Particle::m_m);
+
+        std::uniform_real_distribution<> dist(0, 2 * 3.14159265358979323);
+
+        double sumVx[W] = {}, sumVy[W] = {};
+
+        for (size_t i = 0; i < m_size; ++i)
+        {
+            for (size_t l = 0; l < W; ++l)
+            {
+                double angle = dist(m_gen);
+
+                m_vX[i * W + l] = V * cos(angle);
+                m_vY[i * W + l] = V * sin(angle);
+
+                sumVx[l] += m_vX[i * W + l];
+                sumVy[l] += m_vY[i * W + l];
+            }
+        }
+
+        for (size_t i = 0; i < m_size; ++i)
+        {
+            for (size_t l = 0; l < W; ++l)
+            {
+                m_vX[i * W + l] -= sumVx[l] / m_size;
+                m_vY[i * W + l] -= sumVy[l] / m_size;
+            }
+        }
+    };
+};
+
+// instantiated by the core library for the width of the analysis, see the end of evaporation.h
+#ifdef EVAPORATION_CORE
+extern template void ReplicaBatch<8>::Process(uint32_t);
+extern template void ReplicaBatch<8>::Process();
+#endif
+
+#endif    // REPLICA_BATCH_H
@@ -0,0 +1,318 @@
+#ifndef RESULT_FILE_H
+#define RESULT_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+//*********************************************************************************************************
+// ResultRecord - result of one replica of a sweep
+//*********************************************************************************************************
+struct ResultRecord
+{
+    double   m_period           = 0;                                                 //!< Period of grid in equilibrium distances
+    uint64_t m_seed             = 0;                                                 //!< Seed of initial velocities of the batch of replica
+    uint32_t m_stopIteration    = 0;                                                 //!< Iteration at which the replica was stopped
+    double   m_temperature      = 0;                                                 //!< Mean temperature in K
+    double   m_temperatureError = 0;                                                 //!< Error bar of mean temperature in K
+    uint32_t m_loss             = 0;                                                 //!< Number of particles out of modeling space
+    bool     m_converged        = true;                                              //!< Error bar reached its plateau, else a lower bound
+};
+
+//*********************************************************************************************************
+// Binary result file of a sweep
+//*********************************************************************************************************
+// Layout, native byte order:
+//   header: magic "EVAPRES", version, width, height, reserved zero, all uint32 after the 8 magic bytes
+//   blocks: uint64 number of records n, then columns of n values each in order
+//           period, temperature, temperature error (double), seed (uint64), stop iteration, loss (uint32),
+//           converged error (uint8, 0 - the error is a lower bound), the last one since version 2
+// Columns of a block are written at once, so a reader can take a single column without parsing text.
+// Version 1 files are read as if all errors were converged.
+//*********************************************************************************************************
+namespace result_file
+{
+    constexpr static char     magic[8]  = "EVAPRES";                                 //!< First bytes of file
+    constexpr static uint32_t version   = 2;                                         //!< Version of layout
+    constexpr static uint64_t maxBlock  = uint64_t(1) << 24;                         //!< Largest block a reader accepts
+}
+
+//*********************************************************************************************************
+// ResultWriter - write results of replicas in columnar blocks
+//*********************************************************************************************************
+class ResultWriter
+{
+private:    // variables
+
+    constexpr static size_t m_blockSize = 4096;                                      //!< Records in a full block
+
+    std::ofstream         m_file;                                                    //!< Output file
+    std::vector<double>   m_period;                                                  //!< Column of periods
+    std::vector<double>   m_temperature;                                             //!< Column of temperatures
+    std::vector<double>   m_temperatureError;                                        //!< Column of temperature errors
+    std::vector<uint64_t> m_seed;                                                    //!< Column of seeds
+    std::vector<uint32_t> m_stopIteration;                                           //!< Column of stop iterations
+    std::vector<uint32_t> m_loss;                                                    //!< Column of losses
+    std::vector<uint8_t>  m_converged;                                               //!< Column of flags of converged errors
+
+public:     // methods
+
+    //*****************************************************************************************************
+    // Constructor - create file and write header
+    //*****************************************************************************************************
+    //! @param [in] path path of file
+    //! @param [in] width number of particles along the y axis
+    //! @param [in] height number of particles along the x axis
+    //*****************************************************************************************************
+    ResultWriter(const std::string& path, uint32_t width, uint32_t height)
+        : m_file(path, std::ios::binary | std::ios::trunc)
+    {
+        uint32_t header[4] = { result_file::version, width, height, 0 };
+
+        m_file.write(result_file::magic, sizeof(result_file::magic));
+        m_file.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+        for (auto v : {&m_period, &m_temperature, &m_temperatureError})
+            v->reserve(m_blockSize);
+
+        m_seed.reserve(m_blockSize);
+        m_stopIteration.reserve(m_blockSize);
+        m_loss.reserve(m_blockSize);
+        m_converged.reserve(m_blockSize);
+    };
+
+    ResultWriter(const ResultWriter&) = delete;
+    ResultWriter& operator=(const ResultWriter&) = delete;
+
+    //*****************************************************************************************************
+    // Destructor - write the last block
+    //*****************************************************************************************************
+    ~ResultWriter()
+    {
+        Flush();
+    };
+
+    //*****************************************************************************************************
+    // IsOpen() - check that file was created and all writes succeeded
+    //*****************************************************************************************************
+    //! @return true if file is fine
+    //*****************************************************************************************************
+    bool IsOpen() const
+    {
+        return m_file.good();
+    };
+
+    //*****************************************************************************************************
+    // Add() - add result of replica, full blocks are written to file
+    //*****************************************************************************************************
+    //! @param [in] record result of replica
+    //*****************************************************************************************************
+    void Add(const ResultRecord& record)
+    {
+        m_period.push_back(record.m_period);
+        m_temperature.push_back(record.m_temperature);
+        m_temperatureError.push_back(record.m_temperatureError);
+        m_seed.push_back(record.m_seed);
+        m_stopIteration.push_back(record.m_stopIteration);
+        m_loss.push_back(record.m_loss);
+        m_converged.push_back(record.m_converged);
+
+        if (m_period.size() == m_blockSize)
+            Flush();
+    };
+
+    //*****************************************************************************************************
+    // Flush() - write added records as a block
+    //*****************************************************************************************************
+    void Flush()
+    {
+        uint64_t count = m_period.size();
+
+        if (count == 0)
+            return;
+
+        m_file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+
+        write(m_period);
+        write(m_temperature);
+        write(m_temperatureError);
+        write(m_seed);
+        write(m_stopIteration);
+        write(m_loss);
+        write(m_converged);
+
+        m_file.flush();
+
+        for (auto v : {&m_period, &m_temperature, &m_temperatureError})
+            v->clear();
+
+        m_seed.clear();
+        m_stopIteration.clear();
+        m_loss.clear();
+        m_converged.clear();
+    };
+
+private:    // methods
+
+    //*****************************************************************************************************
+    // write() - write column
+    //*****************************************************************************************************
+    //! @param [in] column values of column
+    //*****************************************************************************************************
+    template <typename T>
+    void write(const std::vector<T>& column)
+    {
+        m_file.write(reinterpret_cast<const char*>(column.data()), column.size() * sizeof(T));
+    };
+};
+
+//*********************************************************************************************************
+// ResultReader - read results of replicas written by ResultWriter
+//*********************************************************************************************************
+class ResultReader
+{
+private:    // variables
+
+    std::ifstream         m_file;                                                    //!< Input file
+    uint32_t              m_width   = 0;                                             //!< Number of particles along the y axis
+    uint32_t              m_height  = 0;                                             //!< Number of particles along the x axis
+    uint32_t              m_version = 0;                                             //!< Version of layout of the file
+    bool                  m_valid   = false;                                         //!< Header was read and matches
+
+    std::vector<double>   m_period;                                                  //!< Column of periods of current block
+    std::vector<double>   m_temperature;                                             //!< Column of temperatures of current block
+    std::vector<double>   m_temperatureError;                                        //!< Column of temperature errors of current block
+    std::vector<uint64_t> m_seed;                                                    //!< Column of seeds of current block
+    std::vector<uint32_t> m_stopIteration;                                           //!< Column of stop iterations of current block
+    std::vector<uint32_t> m_loss;                                                    //!< Column of losses of current block
+    std::vector<uint8_t>  m_converged;                                               //!< Column of flags of converged errors of current block
+    size_t                m_next = 0;                                                //!< Next record of current block
+
+public:     // methods
+
+    //*****************************************************************************************************
+    // Constructor - open file and read header
+    //*****************************************************************************************************
+    //! @param [in] path path of file
+    //*****************************************************************************************************
+    explicit ResultReader(const std::string& path)
+        : m_file(path, std::ios::binary)
+    {
+        char     magic[sizeof(result_file::magic)] = {};
+        uint32_t header[4] = {};
+
+        m_file.read(magic, sizeof(magic));
+        m_file.read(reinterpret_cast<char*>(header), sizeof(header));
+
+        m_version = header[0];
+        m_valid   = m_file.good() && (memcmp(magic, result_file::magic, sizeof(magic)) == 0) &&
+                    (m_version >= 1) && (m_version <= result_file::version);
+        m_width   = header[1];
+        m_height  = header[2];
+    };
+
+    //*****************************************************************************************************
+    // IsValid() - check that file is a result file of known version
+    //*****************************************************************************************************
+    //! @return true if records can be read
+    //*****************************************************************************************************
+    bool IsValid() const
+    {
+        return m_valid;
+    };
+
+    //*****************************************************************************************************
+    // GetWidth() - get number of particles along the y axis
+    //*****************************************************************************************************
+    //! @return width of grid
+    //*****************************************************************************************************
+    uint32_t GetWidth() const
+    {
+        return m_width;
+    };
+
+    //*****************************************************************************************************
+    // GetHeight() - get number of particles along the x axis
+    //*****************************************************************************************************
+    //! @return height of grid
+    //*****************************************************************************************************
+    uint32_t GetHeight() const
+    {
+        return m_height;
+    };
+
+    //*****************************************************************************************************
+    // Next() - read next record
+    //*****************************************************************************************************
+    //! @param [out] record result of replica
+    //! @return false at the end of file or on a truncated block
+    //*****************************************************************************************************
+    bool Next(ResultRecord& record)
+    {
+        if (!m_valid)
+            return false;
+
+        if ((m_next == m_period.size()) && !read_block())
+            return false;
+
+        record.m_period           = m_period[m_next];
+        record.m_temperature      = m_temperature[m_next];
+        record.m_temperatureError = m_temperatureError[m_next];
+        record.m_seed             = m_seed[m_next];
+        record.m_stopIteration    = m_stopIteration[m_next];
+        record.m_loss             = m_loss[m_next];
+        record.m_converged        = (m_version < 2) || (m_converged[m_next] != 0);
+        ++m_next;
+
+        return true;
+    };
+
+private:    // methods
+
+    //*****************************************************************************************************
+    // read_block() - read next block
+    //*****************************************************************************************************
+    //! @return false if there is no whole block or its size is not accepted
+    //*****************************************************************************************************
+    bool read_block()
+    {
+        uint64_t count = 0;
+
+        m_next = 0;
+        m_period.clear();
+
+        // a broken count would allocate columns before the short read is noticed
+        if (!m_file.read(reinterpret_cast<char*>(&count), sizeof(count)) || (count == 0) ||
+            (count > result_file::maxBlock))
+            return false;
+
+        bool ok = read(m_period, count) && read(m_temperature, count) && read(m_temperatureError, count) &&
+                  read(m_seed, count) && read(m_stopIteration, count) && read(m_loss, count) &&
+                  ((m_version < 2) || read(m_converged, count));
+
+        if (!ok)
+            m_period.clear();
+
+        return ok;
+    };
+
+    //*****************************************************************************************************
+    // read() - read column
+    //*****************************************************************************************************
+    //! @param [out] column values of column
+    //! @param [in] count number of values
+    //! @return true if all values were read
+    //*****************************************************************************************************
+    template <typename T>
+    bool read(std::vector<T>& column, uint64_t count)
+    {
+        column.resize(count);
+
+        return bool(m_file.read(reinterpret_cast<char*>(column.data()), count * sizeof(T)));
+    };
+};
+
+#endif    // RESULT_FILE_H
@@ -0,0 +1,76 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+//*********************************************************************************************************
+// RingBuffer - the last values of a time series in fixed memory
+//*********************************************************************************************************
+// Push() overwrites the oldest value when the buffer is full, values are indexed from the oldest one.
+//*********************************************************************************************************
+template <typename T>
+class RingBuffer
+{
+private:    // variables
+
+    std::vector<T> m_values;                                                         //!< Storage of values
+    size_t         m_first = 0;                                                      //!< Index of the oldest value in storage
+    size_t         m_size  = 0;                                                      //!< Number of values
+
+public:     // methods
+
+    //*****************************************************************************************************
+    // Constructor
+    //*****************************************************************************************************
+    //! @param [in] capacity number of kept values
+    //*****************************************************************************************************
+    explicit RingBuffer(size_t capacity)
+        : m_values(std::max<size_t>(capacity, 1))
+    {
+    };
+
+    //*****************************************************************************************************
+    // Push() - add the newest value
+    //*****************************************************************************************************
+    //! @param [in] value value
+    //*****************************************************************************************************
+    void Push(const T& value)
+    {
+        if (m_size < m_values.size())
+        {
+            m_values[(m_first + m_size++) % m_values.size()] = value;
+            return;
+        }
+
+        m_values[m_first] = value;
+        m_first = (m_first + 1) % m_values.size();
+    };
+
+    //*****************************************************************************************************
+    // Clear() - forget all values, memory is kept
+    //*****************************************************************************************************
+    void Clear()
+    {
+        m_first = 0;
+        m_size  = 0;
+    };
+
+    size_t size()     const { return m_size; };
+    size_t capacity() const { return m_values.size(); };
+    bool   empty()    const { return m_size == 0; };
+
+    //*****************************************************************************************************
+    // operator[] - get value
+    //*****************************************************************************************************
+    //! @param [in] i index of value, 0 is the oldest one
+    //! @return value
+    //*****************************************************************************************************
+    const T& operator[](size_t i) const
+    {
+        return m_values[(m_first + i) % m_values.size()];
+    };
+};
+
+#endif    // RING_BUFFER_H
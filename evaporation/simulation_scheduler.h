@@ -0,0 +1,259 @@
+#ifndef SIMULATION_SCHEDULER_H
+#define SIMULATION_SCHEDULER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+//*********************************************************************************************************
+// ScheduleMode - how a scheduler paces the model
+//*********************************************************************************************************
+enum class ScheduleMode
+{
+    TargetRate,                                                                      //!< Iterations per second set by SetRate(), batches fit the frame budget
+    MaxThroughput,                                                                   //!< No pauses, batches fit the frame budget
+    FixedBatch                                                                       //!< No pauses, batches of SetBatch() iterations
+};
+
+//*********************************************************************************************************
+// SimulationScheduler - process a model on its own thread in batches of iterations
+//*********************************************************************************************************
+// A batch is followed by the callback, so observers get results at a steady pace whatever the speed of
+// the model: in adaptive modes the batch is sized from the measured time of an iteration to take about
+// the frame budget. The target rate is kept by sleeping until the deadline of every batch; a scheduler
+// which falls behind does not sleep and does not try to catch up later. Setters may be called from any
+// thread, the next batch takes the new values.
+//*********************************************************************************************************
+template <typename System>
+class SimulationScheduler
+{
+private:    // types
+
+    using Clock = std::chrono::steady_clock;                                         //!< Clock of pacing
+
+private:    // variables
+
+    System&                       m_model;                                           //!< Processed model
+    std::function<void(uint32_t)> m_callback;                                        //!< Called after every batch with its iterations
+
+    std::atomic<ScheduleMode>     m_mode        {ScheduleMode::TargetRate};          //!< Pacing mode
+    std::atomic<double>           m_rate        {100};                               //!< Target iterations per second
+    std::atomic<uint32_t>         m_fixedBatch  {20};                                //!< Iterations of a batch in FixedBatch mode
+    std::atomic<double>           m_frameBudget {1. / 30};                           //!< Time of a batch in adaptive modes, s
+    std::atomic<uint32_t>         m_maxBatch    {100000};                            //!< Largest batch in adaptive modes
+
+    std::atomic<bool>             m_running     {false};                             //!< Thread should go on
+    std::atomic<double>           m_achieved    {0};                                 //!< Measured iterations per second
+    std::atomic<uint32_t>         m_batch       {1};                                 //!< Iterations of the last batch
+    std::mutex                    m_mutex;                                           //!< Mutex for waking up the thread
+    std::condition_variable       m_wake;                                            //!< Wakes up the thread from a pause to stop
+    std::thread                   m_thread;                                          //!< Thread processing the model
+
+public:     // methods
+
+    //*****************************************************************************************************
+    // Constructor
+    //*****************************************************************************************************
+    //! @param [in] model model with Process(uint32_t iterations)
+    //! @param [in, optional] callback function called on the thread of scheduler after every batch
+    //*****************************************************************************************************
+    explicit SimulationScheduler(System& model, std::function<void(uint32_t)> callback = {})
+        : m_model(model)
+        , m_callback(std::move(callback))
+    {
+    };
+
+    SimulationScheduler(const SimulationScheduler&)            = delete;
+    SimulationScheduler& operator=(const SimulationScheduler&) = delete;
+
+    //*****************************************************************************************************
+    // Destructor - stop processing
+    //*****************************************************************************************************
+    ~SimulationScheduler()
+    {
+        Stop();
+    };
+
+    //*****************************************************************************************************
+    // Start() - start processing on the thread of scheduler
+    //*****************************************************************************************************
+    void Start()
+    {
+        if (m_thread.joinable())
+            return;
+
+        m_running  = true;
+        m_achieved = 0;
+        m_thread   = std::thread([this] { run(); });
+    };
+
+    //*****************************************************************************************************
+    // Stop() - stop processing after the current batch and wait for it
+    //*****************************************************************************************************
+    void Stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running = false;
+        }
+
+        m_wake.notify_all();
+
+        if (m_thread.joinable())
+            m_thread.join();
+    };
+
+    //*****************************************************************************************************
+    // IsRunning() - check that the model is processed
+    //*****************************************************************************************************
+    //! @return true between Start() and Stop()
+    //*****************************************************************************************************
+    bool IsRunning() const
+    {
+        return m_running;
+    };
+
+    //*****************************************************************************************************
+    // SetMode() - set pacing mode
+    //*****************************************************************************************************
+    //! @param [in] mode mode
+    //*****************************************************************************************************
+    void SetMode(ScheduleMode mode)
+    {
+        m_mode = mode;
+    };
+
+    //*****************************************************************************************************
+    // SetRate() - set target iterations per second of TargetRate mode
+    //*****************************************************************************************************
+    //! @param [in] rate iterations per second
+    //*****************************************************************************************************
+    void SetRate(double rate)
+    {
+        if (rate > 0)
+            m_rate = rate;
+    };
+
+    //*****************************************************************************************************
+    // SetBatch() - set iterations of a batch of FixedBatch mode
+    //*****************************************************************************************************
+    //! @param [in] batch iterations
+    //*****************************************************************************************************
+    void SetBatch(uint32_t batch)
+    {
+        m_fixedBatch = std::max(1u, batch);
+    };
+
+    //*****************************************************************************************************
+    // SetFrameBudget() - set time of a batch of adaptive modes
+    //*****************************************************************************************************
+    //! @param [in] seconds time of a batch
+    //! @param [in, optional] maxBatch largest batch
+    //*****************************************************************************************************
+    void SetFrameBudget(double seconds, uint32_t maxBatch = 100000)
+    {
+        if (seconds > 0)
+            m_frameBudget = seconds;
+
+        m_maxBatch = std::max(1u, maxBatch);
+    };
+
+    //*****************************************************************************************************
+    // GetAchievedRate() - get measured iterations per second
+    //*****************************************************************************************************
+    //! @return iterations per second averaged over about half a second, 0 before the first measurement
+    //*****************************************************************************************************
+    double GetAchievedRate() const
+    {
+        return m_achieved;
+    };
+
+    //*****************************************************************************************************
+    // GetBatch() - get iterations of the last batch
+    //*****************************************************************************************************
+    //! @return iterations
+    //*****************************************************************************************************
+    uint32_t GetBatch() const
+    {
+        return m_batch;
+    };
+
+private:    // methods
+
+    //*****************************************************************************************************
+    // run() - process batches until Stop()
+    //*****************************************************************************************************
+    void run()
+    {
+        double   iterationTime = 0;                                                  // smoothed time of one iteration, s
+        auto     deadline      = Clock::now();
+        auto     windowStart   = deadline;
+        uint64_t windowDone    = 0;
+
+        while (m_running)
+        {
+            ScheduleMode mode   = m_mode;
+            double       budget = m_frameBudget;
+            uint32_t     batch  = m_fixedBatch;
+
+            // the first batch of an adaptive mode is one iteration, which measures its time
+            if (mode != ScheduleMode::FixedBatch)
+            {
+                double iterations = (iterationTime > 0) ? budget / iterationTime : 1;
+
+                if (mode == ScheduleMode::TargetRate)
+                    iterations = std::min(iterations, std::max(1., m_rate * budget));
+
+                batch = uint32_t(std::clamp(iterations, 1., double(m_maxBatch.load())));
+            }
+
+            auto begin = Clock::now();
+
+            m_model.Process(batch);
+
+            auto end = Clock::now();
+
+            double seconds = std::chrono::duration<double>(end - begin).count() / batch;
+
+            iterationTime = (iterationTime > 0) ? 0.8 * iterationTime + 0.2 * seconds : seconds;
+            m_batch       = batch;
+
+            if (m_callback)
+                m_callback(batch);
+
+            windowDone += batch;
+
+            double window = std::chrono::duration<double>(Clock::now() - windowStart).count();
+
+            if (window >= 0.5)
+            {
+                m_achieved  = windowDone / window;
+                windowStart = Clock::now();
+                windowDone  = 0;
+            }
+
+            if (mode != ScheduleMode::TargetRate)
+            {
+                deadline = Clock::now();
+                continue;
+            }
+
+            deadline += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(batch / m_rate));
+
+            // behind the schedule by more than a batch, the lost time is forgotten
+            if (deadline < Clock::now() - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(budget)))
+                deadline = Clock::now();
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait_until(lock, deadline, [this] { return !m_running; });
+        }
+    };
+};
+
+#endif    // SIMULATION_SCHEDULER_H
@@ -0,0 +1,58 @@
+#ifndef SPAN_H
+#define SPAN_H
+
+#include <cstddef>
+
+//*********************************************************************************************************
+// Span - view of contiguous values owned by the caller, the part of std::span needed here
+//*********************************************************************************************************
+// Engines fill spans instead of returning new vectors, so callers can keep their buffers between calls.
+//*********************************************************************************************************
+template <typename T>
+class Span
+{
+private:    // variables
+
+    T*     m_data = nullptr;                                                         //!< First value
+    size_t m_size = 0;                                                               //!< Number of values
+
+public:     // methods
+
+    //*****************************************************************************************************
+    // Default constructor - empty span
+    //*****************************************************************************************************
+    Span() = default;
+
+    //*****************************************************************************************************
+    // Constructor
+    //*****************************************************************************************************
+    //! @param [in] data first value
+    //! @param [in] size number of values
+    //*****************************************************************************************************
+    Span(T* data, size_t size)
+        : m_data(data)
+        , m_size(size)
+    {
+    };
+
+    //*****************************************************************************************************
+    // Constructor - view of whole container with data() and size(), like std::vector or QVector
+    //*****************************************************************************************************
+    //! @param [in] container container of values
+    //*****************************************************************************************************
+    template <typename Container>
+    Span(Container& container)
+        : Span(container.data(), size_t(container.size()))
+    {
+    };
+
+    T*     data()  const { return m_data; };
+    size_t size()  const { return m_size; };
+    bool   empty() const { return m_size == 0; };
+    T*     begin() const { return m_data; };
+    T*     end()   const { return m_data + m_size; };
+
+    T& operator[](size_t i) const { return m_data[i]; };
+};
+
+#endif    // SPAN_H
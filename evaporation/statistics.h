@@ -0,0 +1,291 @@
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+//*********************************************************************************************************
+// RunningStatistics - mean and variance of a stream of values by Welford's method
+//*********************************************************************************************************
+class RunningStatistics
+{
+private:    // variables
+
+    uint64_t m_count = 0;                                                            //!< Number of values
+    double   m_mean  = 0;                                                            //!< Mean of values
+    double   m_m2    = 0;                                                            //!< Sum of squared deviations from the mean
+
+public:     // methods
+
+    //*****************************************************************************************************
+    // Add() - add value
+    //*****************************************************************************************************
+    //! @param [in] x value
+    //*****************************************************************************************************
+    void Add(double x)
+    {
+        ++m_count;
+
+        double delta = x - m_mean;
+
+        m_mean += delta / m_count;
+        m_m2   += delta * (x - m_mean);
+    };
+
+    //*****************************************************************************************************
+    // Merge() - add all values of other statistics, Chan's parallel formula
+    //*****************************************************************************************************
+    //! @param [in] other statistics of other values
+    //*****************************************************************************************************
+    void Merge(const RunningStatistics& other)
+    {
+        if (other.m_count == 0)
+            return;
+
+        uint64_t count = m_count + other.m_count;
+        double   delta = other.m_mean - m_mean;
+
+        m_mean += delta * other.m_count / count;
+        m_m2   += other.m_m2 + delta * delta * (double(m_count) * other.m_count / count);
+        m_count = count;
+    };
+
+    //*****************************************************************************************************
+    // Reset() - forget all values
+    //*****************************************************************************************************
+    void Reset()
+    {
+        *this = RunningStatistics();
+    };
+
+    //*****************************************************************************************************
+    // GetCount() - get number of values
+    //*****************************************************************************************************
+    //! @return number of values
+    //*****************************************************************************************************
+    uint64_t GetCount() const
+    {
+        return m_count;
+    };
+
+    //*****************************************************************************************************
+    // GetMean() - get mean of values
+    //*****************************************************************************************************
+    //! @return mean, 0 without values
+    //*****************************************************************************************************
+    double GetMean() const
+    {
+        return m_mean;
+    };
+
+    //*****************************************************************************************************
+    // GetVariance() - get unbiased variance of values
+    //*****************************************************************************************************
+    //! @return variance, 0 for less than two values
+    //*****************************************************************************************************
+    double GetVariance() const
+    {
+        return (m_count > 1) ? m_m2 / (m_count - 1) : 0;
+    };
+
+    //*****************************************************************************************************
+    // GetStandardDeviation() - get standard deviation of values
+    //*****************************************************************************************************
+    //! @return standard deviation
+    //*****************************************************************************************************
+    double GetStandardDeviation() const
+    {
+        return sqrt(GetVariance());
+    };
+
+    //*****************************************************************************************************
+    // GetStandardError() - get standard error of the mean for independent values
+    //*****************************************************************************************************
+    //! @return standard error, infinity for less than two values
+    //*****************************************************************************************************
+    double GetStandardError() const
+    {
+        return (m_count > 1) ? sqrt(GetVariance() / m_count) : std::numeric_limits<double>::infinity();
+    };
+};
+
+//*********************************************************************************************************
+// BlockAverage - mean and its error bar for correlated values, like successive steps of the dynamics
+//*********************************************************************************************************
+// Blocking of Flyvbjerg and Petersen: level l keeps statistics of means of blocks of 2^l values.
+// The standard error grows with the level until blocks are longer than the correlation time and
+// becomes flat. The error is the largest one over levels with at least m_minBlocks blocks. It is
+// converged after the plateau: errors of the m_plateauLevels longest of these levels agree within
+// their own uncertainty, err / sqrt(2 (n - 1)) for n blocks. Before that it is a lower bound.
+// Adding a value costs two Welford updates on average, memory does not grow.
+//*********************************************************************************************************
+class BlockAverage
+{
+private:    // types
+
+    //*****************************************************************************************************
+    // Level - blocks of one length
+    //*****************************************************************************************************
+    struct Level
+    {
+        RunningStatistics m_blocks;                                                  //!< Statistics of block means
+        double            m_pending    = 0;                                          //!< Mean of the first half of the next block
+        bool              m_hasPending = false;                                      //!< First half of the next block is ready
+    };
+
+private:    // variables
+
+    constexpr static size_t   m_levels        = 48;                                  //!< Number of levels, enough for 2^48 values
+    constexpr static uint64_t m_minBlocks     = 32;                                  //!< Fewest blocks for a trusted error of a level
+    constexpr static size_t   m_plateauLevels = 3;                                   //!< Longest trusted levels which have to agree
+
+    std::array<Level, m_levels> m_level;                                             //!< Levels of blocking
+
+public:     // methods
+
+    //*****************************************************************************************************
+    // Add() - add value
+    //*****************************************************************************************************
+    //! @param [in] x value
+    //*****************************************************************************************************
+    void Add(double x)
+    {
+        for (auto& level : m_level)
+        {
+            level.m_blocks.Add(x);
+
+            if (!level.m_hasPending)
+            {
+                level.m_pending    = x;
+                level.m_hasPending = true;
+                return;
+            }
+
+            // block of this level is complete, its mean goes one level up
+            x = (level.m_pending + x) / 2;
+            level.m_hasPending = false;
+        }
+    };
+
+    //*****************************************************************************************************
+    // Reset() - forget all values
+    //*****************************************************************************************************
+    void Reset()
+    {
+        m_level = {};
+    };
+
+    //*****************************************************************************************************
+    // GetCount() - get number of values
+    //*****************************************************************************************************
+    //! @return number of values
+    //*****************************************************************************************************
+    uint64_t GetCount() const
+    {
+        return m_level[0].m_blocks.GetCount();
+    };
+
+    //*****************************************************************************************************
+    // GetMean() - get mean of values
+    //*****************************************************************************************************
+    //! @return mean
+    //*****************************************************************************************************
+    double GetMean() const
+    {
+        return m_level[0].m_blocks.GetMean();
+    };
+
+    //*****************************************************************************************************
+    // GetStandardDeviation() - get standard deviation of values
+    //*****************************************************************************************************
+    //! @return standard deviation
+    //*****************************************************************************************************
+    double GetStandardDeviation() const
+    {
+        return m_level[0].m_blocks.GetStandardDeviation();
+    };
+
+    //*****************************************************************************************************
+    // GetError() - get error bar of the mean which takes correlations into account
+    //*****************************************************************************************************
+    //! @return standard error, a lower bound until IsConverged(), infinity for less than two values
+    //*****************************************************************************************************
+    double GetError() const
+    {
+        size_t trusted = get_trusted_levels();
+
+        if (trusted == 0)
+            return m_level[0].m_blocks.GetStandardError();
+
+        double error = 0;
+
+        for (size_t l = 0; l < trusted; ++l)
+            error = std::max(error, m_level[l].m_blocks.GetStandardError());
+
+        return error;
+    };
+
+    //*****************************************************************************************************
+    // IsConverged() - check that blocking has reached the plateau, so GetError() is the error bar
+    //*****************************************************************************************************
+    //! @return true if the longest trusted levels agree
+    //*****************************************************************************************************
+    bool IsConverged() const
+    {
+        size_t trusted = get_trusted_levels();
+
+        if (trusted < m_plateauLevels)
+            return false;
+
+        // errors still growing with the length of blocks are shorter than the correlation time
+        for (size_t l = trusted - m_plateauLevels; l + 1 < trusted; ++l)
+        {
+            const auto& a = m_level[l].m_blocks;
+            const auto& b = m_level[l + 1].m_blocks;
+
+            double spread = a.GetStandardError() / sqrt(2. * (a.GetCount() - 1)) +
+                            b.GetStandardError() / sqrt(2. * (b.GetCount() - 1));
+
+            if (std::abs(b.GetStandardError() - a.GetStandardError()) > spread)
+                return false;
+        }
+
+        return true;
+    };
+
+    //*****************************************************************************************************
+    // GetInefficiency() - get statistical inefficiency, number of values per independent one
+    //*****************************************************************************************************
+    //! @return ratio of squared error bar to squared error of independent values, 1 if not known
+    //*****************************************************************************************************
+    double GetInefficiency() const
+    {
+        double naive = m_level[0].m_blocks.GetStandardError();
+        double error = GetError();
+
+        return (IsConverged() && (naive > 0)) ? std::max(1.0, error * error / (naive * naive)) : 1;
+    };
+
+private:    // methods
+
+    //*****************************************************************************************************
+    // get_trusted_levels() - get number of levels with enough blocks for their error
+    //*****************************************************************************************************
+    //! @return number of levels, all of them are shorter than the rest
+    //*****************************************************************************************************
+    size_t get_trusted_levels() const
+    {
+        size_t trusted = 0;
+
+        while ((trusted < m_levels) && (m_level[trusted].m_blocks.GetCount() >= m_minBlocks))
+            ++trusted;
+
+        return trusted;
+    };
+};
+
+#endif    // STATISTICS_H
@@ -0,0 +1,318 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+//*********************************************************************************************************
+// ThreadPool - fixed set of worker threads for data parallel loops
+//*********************************************************************************************************
+// Run() splits the work into tasks which are taken by workers and the calling thread one by one,
+// so the caller is one of the threads and a pool of size 1 has no workers at all. StaticFor()
+// gives every thread the same part of a range on every call, so data first touched by a thread
+// stays on its NUMA node when threads are pinned.
+//*********************************************************************************************************
+class ThreadPool
+{
+private:    // variables
+
+    std::vector<std::thread>                  m_workers;                             //!< Worker threads
+    std::mutex                                m_mutex;                               //!< Mutex for job data
+    std::condition_variable                   m_start;                               //!< Signals new job to workers
+    std::condition_variable                   m_done;                                //!< Signals finished job to caller
+    std::function<void(size_t, size_t)>      m_job;                                 //!< Current job, called with task and thread index
+    size_t                                    m_tasks      = 0;                      //!< Number of tasks in current job
+    std::atomic<size_t>                       m_next       {0};                      //!< Next task to take
+    size_t                                    m_busy       = 0;                      //!< Workers which have not finished current job
+    uint64_t                                  m_generation = 0;                      //!< Number of started jobs
+    bool                                      m_stop       = false;                  //!< Workers should exit
+    bool                                      m_static     = false;                  //!< Task of current job is given by thread index
+    std::vector<int>                          m_cpus;                                //!< CPU of every thread, empty when threads are not pinned
+#ifdef __linux__
+    pthread_t                                 m_caller     = {};                     //!< Thread which built the pool
+    cpu_set_t                                 m_callerCpus = {};                     //!< CPUs of the caller before it was pinned
+    bool                                      m_restore    = false;                  //!< Caller was pinned and gets its CPUs back
+#endif
+
+public:     // methods
+
+    //*****************************************************************************************************
+    // Constructor
+    //*****************************************************************************************************
+    //! @param [in, optional] threads number of threads including the caller, 0 means hardware concurrency
+    //! @param [in, optional] cpus CPUs to pin threads to, thread t gets cpus[t % size], empty to not pin;
+    //!                        the calling thread is pinned too until the pool is destroyed
+    //*****************************************************************************************************
+    explicit ThreadPool(size_t threads = 0, const std::vector<int>& cpus = {})
+    {
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+
+        for (size_t t = 0; (t < threads) && !cpus.empty(); ++t)
+            m_cpus.push_back(cpus[t % cpus.size()]);
+
+        // workers inherit CPUs of the caller, so they are started before it is pinned
+        for (size_t t = 1; t < threads; ++t)
+            m_workers.emplace_back([this, t] { pin(t); worker(t); });
+
+#ifdef __linux__
+        m_caller  = pthread_self();
+        m_restore = !m_cpus.empty() && (pthread_getaffinity_np(m_caller, sizeof(m_callerCpus), &m_callerCpus) == 0);
+#endif
+
+        pin(0);
+    };
+
+    //*****************************************************************************************************
+    // Destructor
+    //*****************************************************************************************************
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+
+        m_start.notify_all();
+
+        for (auto& w : m_workers)
+            w.join();
+
+#ifdef __linux__
+        // threads started later by the caller would inherit the single CPU of thread 0 otherwise
+        if (m_restore && pthread_equal(m_caller, pthread_self()))
+            pthread_setaffinity_np(m_caller, sizeof(m_callerCpus), &m_callerCpus);
+#endif
+    };
+
+    ThreadPool(const ThreadPool&)            = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    //*****************************************************************************************************
+    // GetThreadsAmount() - get number of threads including the caller
+    //*****************************************************************************************************
+    //! @return number of threads
+    //*****************************************************************************************************
+    size_t GetThreadsAmount() const
+    {
+        return m_workers.size() + 1;
+    };
+
+    //*****************************************************************************************************
+    // GetCpu() - get CPU which thread is pinned to
+    //*****************************************************************************************************
+    //! @param [in] thread index of thread
+    //! @return index of CPU, -1 when threads are not pinned
+    //*****************************************************************************************************
+    int GetCpu(size_t thread) const
+    {
+        return (thread < m_cpus.size()) ? m_cpus[thread] : -1;
+    };
+
+    //*****************************************************************************************************
+    // Run() - execute tasks on all threads and wait for them
+    //*****************************************************************************************************
+    //! @param [in] tasks number of tasks
+    //! @param [in] job function called as job(task, thread) for every task
+    //*****************************************************************************************************
+    template <typename Job>
+    void Run(size_t tasks, Job&& job)
+    {
+        if (m_workers.empty() || (tasks <= 1))
+        {
+            for (size_t task = 0; task < tasks; ++task)
+                job(task, 0);
+
+            return;
+        }
+
+        start(tasks, std::ref(job), false);
+    };
+
+    //*****************************************************************************************************
+    // StaticFor() - split range into one contiguous part per thread, thread t always gets part t
+    //*****************************************************************************************************
+    //! @param [in] begin first index
+    //! @param [in] end index after the last one
+    //! @param [in] body function called as body(part_begin, part_end, thread)
+    //*****************************************************************************************************
+    template <typename Body>
+    void StaticFor(size_t begin, size_t end, Body&& body)
+    {
+        if (end <= begin)
+            return;
+
+        auto job = [&](size_t thread, size_t)
+        {
+            auto [first, last] = StaticPart(begin, end, thread);
+
+            if (first < last)
+                body(first, last, thread);
+        };
+
+        if (m_workers.empty())
+        {
+            job(0, 0);
+            return;
+        }
+
+        start(GetThreadsAmount(), std::ref(job), true);
+    };
+
+    //*****************************************************************************************************
+    // StaticPart() - part of range which thread gets in StaticFor()
+    //*****************************************************************************************************
+    //! @param [in] begin first index
+    //! @param [in] end index after the last one
+    //! @param [in] thread index of thread
+    //! @return first index and index after the last one of the part
+    //*****************************************************************************************************
+    std::pair<size_t, size_t> StaticPart(size_t begin, size_t end, size_t thread) const
+    {
+        size_t threads = GetThreadsAmount();
+        size_t size    = end - begin;
+
+        return { begin + size * thread / threads, begin + size * (thread + 1) / threads };
+    };
+
+    //*****************************************************************************************************
+    // ParallelFor() - split range into contiguous chunks and process them on all threads
+    //*****************************************************************************************************
+    //! @param [in] begin first index
+    //! @param [in] end index after the last one
+    //! @param [in] body function called as body(chunk_begin, chunk_end, thread)
+    //*****************************************************************************************************
+    template <typename Body>
+    void ParallelFor(size_t begin, size_t end, Body&& body)
+    {
+        if (end <= begin)
+            return;
+
+        // a few chunks per thread keep threads balanced when chunks cost differently
+        size_t chunks = std::min(end - begin, 4 * GetThreadsAmount());
+        size_t step   = (end - begin + chunks - 1) / chunks;
+
+        Run((end - begin + step - 1) / step, [&](size_t task, size_t thread)
+        {
+            size_t first = begin + task * step;
+
+            body(first, std::min(first + step, end), thread);
+        });
+    };
+
+private:    // methods
+
+    //*****************************************************************************************************
+    // start() - give job to workers, run its tasks on the calling thread too and wait for workers
+    //*****************************************************************************************************
+    //! @param [in] tasks number of tasks
+    //! @param [in] job function called as job(task, thread)
+    //! @param [in] fixed task of every thread is its index
+    //*****************************************************************************************************
+    void start(size_t tasks, std::function<void(size_t, size_t)> job, bool fixed)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            m_job    = std::move(job);
+            m_tasks  = tasks;
+            m_busy   = m_workers.size();
+            m_static = fixed;
+            m_next.store(0);
+            ++m_generation;
+        }
+
+        m_start.notify_all();
+
+        execute(0);
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this] { return m_busy == 0; });
+        m_job = nullptr;
+    };
+
+    //*****************************************************************************************************
+    // execute() - take and run tasks of the current job until none are left
+    //*****************************************************************************************************
+    //! @param [in] thread index of the calling thread
+    //*****************************************************************************************************
+    void execute(size_t thread)
+    {
+        if (m_static)
+        {
+            if (thread < m_tasks)
+                m_job(thread, thread);
+
+            return;
+        }
+
+        for (size_t task = m_next++; task < m_tasks; task = m_next++)
+            m_job(task, thread);
+    };
+
+    //*****************************************************************************************************
+    // pin() - bind calling thread to its CPU
+    //*****************************************************************************************************
+    //! @param [in] thread index of the calling thread
+    //*****************************************************************************************************
+    void pin(size_t thread)
+    {
+#ifdef __linux__
+        if (thread >= m_cpus.size())
+            return;
+
+        cpu_set_t set;
+
+        CPU_ZERO(&set);
+        CPU_SET(m_cpus[thread], &set);
+
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+        (void)thread;
+#endif
+    };
+
+    //*****************************************************************************************************
+    // worker() - loop of worker thread
+    //*****************************************************************************************************
+    //! @param [in] thread index of the worker
+    //*****************************************************************************************************
+    void worker(size_t thread)
+    {
+        uint64_t generation = 0;
+
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_start.wait(lock, [&] { return m_stop || (m_generation != generation); });
+
+                if (m_stop)
+                    return;
+
+                generation = m_generation;
+            }
+
+            execute(thread);
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            if (--m_busy == 0)
+                m_done.notify_one();
+        }
+    };
+};
+
+#endif    // THREAD_POOL_H
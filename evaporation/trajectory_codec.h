@@ -0,0 +1,764 @@
+#ifndef TRAJECTORY_CODEC_H
+#define TRAJECTORY_CODEC_H
+
+#include "span.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+//*********************************************************************************************************
+// Compressed trajectory frames
+//*********************************************************************************************************
+// A coordinate is stored as the nearest multiple of a quantum, so its error is at most half of the
+// quantum. Quanta are delta encoded against the previous frame moved by its own change, so atoms flying
+// steadily cost almost nothing; key frames are encoded against zero.
+// Deltas are zigzag mapped to unsigned values and written by Rice codes, their parameter is chosen for
+// every axis of every chunk of atoms. Chunks are encoded independently on threads of a pool.
+//
+// Frame layout, native byte order:
+//   iteration (uint32), key frame flag (uint32), quantum (double), atoms (uint64), chunks (uint64),
+//   size of every chunk in bytes (uint64), then chunks; a chunk has Dim parts of one axis each:
+//   Rice parameter (uint8) and bits of codes padded to whole bytes.
+//*********************************************************************************************************
+namespace trajectory_codec
+{
+    constexpr static size_t   chunkAtoms = 16384;                                    //!< Atoms in a chunk
+    constexpr static uint32_t maxUnary   = 32;                                       //!< Longest unary part, longer codes are escaped
+    constexpr static size_t   headerSize = 2 * sizeof(uint32_t) + sizeof(double) + 2 * sizeof(uint64_t);
+
+    //*****************************************************************************************************
+    // BitWriter - append bits to a byte buffer, lowest bits first
+    //*****************************************************************************************************
+    class BitWriter
+    {
+    private:    // variables
+
+        std::vector<uint8_t>& m_bytes;                                               //!< Output buffer
+        uint64_t              m_bits  = 0;                                           //!< Bits not written yet
+        uint32_t              m_count = 0;                                           //!< Number of bits not written yet
+
+    public:     // methods
+
+        explicit BitWriter(std::vector<uint8_t>& bytes)
+            : m_bytes(bytes)
+        {
+        };
+
+        //*************************************************************************************************
+        // Write() - append lowest bits of a value
+        //*************************************************************************************************
+        //! @param [in] value bits to append
+        //! @param [in] count number of bits, at most 32
+        //*************************************************************************************************
+        void Write(uint64_t value, uint32_t count)
+        {
+            m_bits  |= (value & ((uint64_t(1) << count) - 1)) << m_count;
+            m_count += count;
+
+            while (m_count >= 8)
+            {
+                m_bytes.push_back(uint8_t(m_bits));
+                m_bits  >>= 8;
+                m_count  -= 8;
+            }
+        };
+
+        //*************************************************************************************************
+        // Finish() - write remaining bits padded by zeros to a whole byte
+        //*************************************************************************************************
+        void Finish()
+        {
+            if (m_count > 0)
+                m_bytes.push_back(uint8_t(m_bits));
+
+            m_bits  = 0;
+            m_count = 0;
+        };
+    };
+
+    //*****************************************************************************************************
+    // BitReader - read bits written by BitWriter
+    //*****************************************************************************************************
+    class BitReader
+    {
+    private:    // variables
+
+        const uint8_t* m_data;                                                       //!< Next byte
+        const uint8_t* m_end;                                                        //!< End of bytes
+        uint64_t       m_bits  = 0;                                                  //!< Bits read from bytes but not taken
+        uint32_t       m_count = 0;                                                  //!< Number of such bits
+        bool           m_over  = false;                                              //!< Bits past the end were taken
+
+    public:     // methods
+
+        BitReader(const uint8_t* data, const uint8_t* end)
+            : m_data(data)
+            , m_end(end)
+        {
+        };
+
+        //*************************************************************************************************
+        // Read() - take bits
+        //*************************************************************************************************
+        //! @param [in] count number of bits, at most 32
+        //! @return bits, missing bits past the end are zeros
+        //*************************************************************************************************
+        uint64_t Read(uint32_t count)
+        {
+            while (m_count < count)
+            {
+                m_over   = m_over || (m_data == m_end);
+                m_bits  |= uint64_t((m_data < m_end) ? *m_data++ : 0) << m_count;
+                m_count += 8;
+            }
+
+            uint64_t value = m_bits & ((uint64_t(1) << count) - 1);
+
+            m_bits  >>= count;
+            m_count  -= count;
+
+            return value;
+        };
+
+        //*************************************************************************************************
+        // IsOver() - check that reading went past the end of bytes
+        //*************************************************************************************************
+        //! @return true if missing bits were taken
+        //*************************************************************************************************
+        bool IsOver() const
+        {
+            return m_over;
+        };
+    };
+
+    //*****************************************************************************************************
+    // write_rice() - write Rice code of value, codes with long unary parts are escaped
+    //*****************************************************************************************************
+    //! @param [in] bits output
+    //! @param [in] value value to write
+    //! @param [in] k Rice parameter
+    //*****************************************************************************************************
+    inline void write_rice(BitWriter& bits, uint64_t value, uint32_t k)
+    {
+        uint64_t unary = value >> k;
+
+        if (unary >= maxUnary)
+        {
+            bits.Write(0xFFFFFFFF, maxUnary);
+            bits.Write(value, 32);
+            bits.Write(value >> 32, 32);
+            return;
+        }
+
+        bits.Write((uint64_t(1) << unary) - 1, uint32_t(unary) + 1);
+
+        for (uint32_t done = 0; done < k; done += 32)
+            bits.Write(value >> done, std::min(32u, k - done));
+    };
+
+    //*****************************************************************************************************
+    // read_rice() - read value written by write_rice()
+    //*****************************************************************************************************
+    //! @param [in] bits input
+    //! @param [in] k Rice parameter
+    //! @return value
+    //*****************************************************************************************************
+    inline uint64_t read_rice(BitReader& bits, uint32_t k)
+    {
+        uint64_t unary = 0;
+
+        while ((unary < maxUnary) && (bits.Read(1) != 0))
+            ++unary;
+
+        if (unary == maxUnary)
+        {
+            uint64_t low = bits.Read(32);
+
+            return low | (bits.Read(32) << 32);
+        }
+
+        uint64_t value = 0;
+
+        for (uint32_t done = 0; done < k; done += 32)
+            value |= bits.Read(std::min(32u, k - done)) << done;
+
+        return (unary << k) | value;
+    };
+
+    inline uint64_t zigzag(int64_t d)   { return (uint64_t(d) << 1) ^ uint64_t(d >> 63); };
+    inline int64_t  unzigzag(uint64_t u) { return int64_t(u >> 1) ^ -int64_t(u & 1); };
+}
+
+//*********************************************************************************************************
+// TrajectoryEncoder - encode coordinates of frames with bounded error
+//*********************************************************************************************************
+template <size_t Dim>
+class TrajectoryEncoder
+{
+private:    // variables
+
+    double                                m_quantum;                                 //!< Step of quantized coordinates
+    uint32_t                              m_keyInterval;                             //!< Frames between key frames
+    uint64_t                              m_frames = 0;                              //!< Number of encoded frames
+    std::array<std::vector<int64_t>, Dim> m_previous;                                //!< Quantized coordinates of the previous frame
+    std::array<std::vector<int64_t>, Dim> m_step;                                    //!< Change of quantized coordinates in the previous frame
+    std::vector<std::vector<uint8_t>>     m_chunks;                                  //!< Encoded chunks of the current frame
+    std::vector<std::vector<uint64_t>>    m_codes;                                   //!< Codes of one axis of every chunk
+    std::unique_ptr<ThreadPool>           m_pool;                                    //!< Threads encoding chunks
+
+public:     // methods
+
+    //*****************************************************************************************************
+    // Constructor
+    //*****************************************************************************************************
+    //! @param [in] precision quantum in equilibrium distances, coordinates are kept within its half
+    //! @param [in] distance equilibrium distance of the model, GetEquilibriumDistance()
+    //! @param [in, optional] threads number of encoding threads, 0 means hardware concurrency
+    //! @param [in, optional] keyInterval frames between key frames, which can be decoded alone
+    //*****************************************************************************************************
+    TrajectoryEncoder(double precision, double distance, size_t threads = 0, uint32_t keyInterval = 100)
+        : m_quantum(precision * distance)
+        , m_keyInterval(std::max(1u, keyInterval))
+        , m_pool(new ThreadPool(threads))
+    {
+    };
+
+    //*****************************************************************************************************
+    // GetQuantum() - get step of quantized coordinates
+    //*****************************************************************************************************
+    //! @return quantum in meters
+    //*****************************************************************************************************
+    double GetQuantum() const
+    {
+        return m_quantum;
+    };
+
+    //*****************************************************************************************************
+    // Reset() - start a new trajectory, the next frame is a key frame
+    //*****************************************************************************************************
+    void Reset()
+    {
+        m_frames = 0;
+    };
+
+    //*****************************************************************************************************
+    // Encode() - encode frame
+    //*****************************************************************************************************
+    //! @param [in] r coordinates, one span per axis of the same size
+    //! @param [in] iteration iteration of the frame
+    //! @param [out] frame encoded frame, previous contents are replaced
+    //*****************************************************************************************************
+    void Encode(const std::array<Span<const double>, Dim>& r, uint32_t iteration, std::vector<uint8_t>& frame)
+    {
+        using namespace trajectory_codec;
+
+        size_t atoms  = r[0].size();
+        size_t chunks = (atoms + chunkAtoms - 1) / chunkAtoms;
+        bool   key    = (m_frames % m_keyInterval == 0) || (m_previous[0].size() != atoms);
+
+        for (size_t k = 0; k < Dim; ++k)
+        {
+            m_previous[k].resize(atoms, 0);
+            m_step[k].resize(atoms, 0);
+        }
+
+        m_chunks.resize(chunks);
+        m_codes.resize(chunks);
+
+        m_pool->Run(chunks, [&](size_t chunk, size_t)
+        {
+            size_t begin = chunk * chunkAtoms;
+            size_t end   = std::min(begin + chunkAtoms, atoms);
+
+            encode_chunk(r, begin, end, key, m_codes[chunk], m_chunks[chunk]);
+        });
+
+        frame.clear();
+        append(frame, iteration);
+        append(frame, uint32_t(key));
+        append(frame, m_quantum);
+        append(frame, uint64_t(atoms));
+        append(frame, uint64_t(chunks));
+
+        for (auto& c : m_chunks)
+            append(frame, uint64_t(c.size()));
+
+        for (auto& c : m_chunks)
+            frame.insert(frame.end(), c.begin(), c.end());
+
+        ++m_frames;
+    };
+
+private:    // methods
+
+    //*****************************************************************************************************
+    // encode_chunk() - quantize and encode atoms of a chunk, all axes
+    //*****************************************************************************************************
+    //! @param [in] r coordinates
+    //! @param [in] begin first atom
+    //! @param [in] end atom after the last one
+    //! @param [in] key frame is encoded against zero
+    //! @param [in] codes buffer for codes of one axis, kept between frames
+    //! @param [out] bytes encoded chunk
+    //*****************************************************************************************************
+    void encode_chunk(const std::array<Span<const double>, Dim>& r, size_t begin, size_t end, bool key,
+                      std::vector<uint64_t>& codes, std::vector<uint8_t>& bytes)
+    {
+        using namespace trajectory_codec;
+
+        codes.resize(end - begin);
+        bytes.clear();
+
+        for (size_t k = 0; k < Dim; ++k)
+        {
+            auto&    previous = m_previous[k];
+            auto&    step     = m_step[k];
+            uint64_t sum      = 0;
+
+            for (size_t i = begin; i < end; ++i)
+            {
+                int64_t q = int64_t(llround(r[k][i] / m_quantum));
+
+                // atoms are predicted to move as in the previous frame
+                codes[i - begin] = zigzag(key ? q : q - previous[i] - step[i]);
+                step[i]          = key ? 0 : q - previous[i];
+                previous[i]      = q;
+                sum             += std::min<uint64_t>(codes[i - begin], uint64_t(1) << 56);
+            }
+
+            // best Rice parameter of a geometric distribution is close to log2 of the mean
+            uint32_t param = 0;
+
+            while ((param < 56) && ((uint64_t(end - begin) << (param + 1)) <= sum))
+                ++param;
+
+            bytes.push_back(uint8_t(param));
+
+            BitWriter bits(bytes);
+
+            for (size_t i = 0; i < end - begin; ++i)
+                write_rice(bits, codes[i], param);
+
+            bits.Finish();
+        }
+    };
+
+    //*****************************************************************************************************
+    // append() - append bytes of a value
+    //*****************************************************************************************************
+    //! @param [in] bytes buffer
+    //! @param [in] value value
+    //*****************************************************************************************************
+    template <typename T>
+    static void append(std::vector<uint8_t>& bytes, T value)
+    {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(&value);
+
+        bytes.insert(bytes.end(), p, p + sizeof(T));
+    };
+};
+
+//*********************************************************************************************************
+// TrajectoryDecoder - decode frames written by TrajectoryEncoder
+//*********************************************************************************************************
+template <size_t Dim>
+class TrajectoryDecoder
+{
+private:    // variables
+
+    std::array<std::vector<int64_t>, Dim> m_previous;                                //!< Quantized coordinates of the previous frame
+    std::array<std::vector<int64_t>, Dim> m_step;                                    //!< Change of quantized coordinates in the previous frame
+    bool                                  m_started = false;                         //!< A key frame has been decoded
+
+public:     // methods
+
+    //*****************************************************************************************************
+    // Reset() - start a new trajectory, the next frame has to be a key frame
+    //*****************************************************************************************************
+    void Reset()
+    {
+        m_started = false;
+    };
+
+    //*****************************************************************************************************
+    // Decode() - decode frame
+    //*****************************************************************************************************
+    //! @param [in] data encoded frame
+    //! @param [in] size size of frame in bytes
+    //! @param [out] r coordinates, one array per axis
+    //! @param [out] iteration iteration of the frame
+    //! @return false for a broken frame or a delta frame without its key frame
+    //*****************************************************************************************************
+    bool Decode(const uint8_t* data, size_t size, std::array<std::vector<double>, Dim>& r, uint32_t& iteration)
+    {
+        using namespace trajectory_codec;
+
+        if (size < headerSize)
+            return false;
+
+        uint32_t key     = 0;
+        double   quantum = 0;
+        uint64_t atoms   = 0;
+        uint64_t chunks  = 0;
+
+        const uint8_t* p = data;
+
+        p = read(p, iteration);
+        p = read(p, key);
+        p = read(p, quantum);
+        p = read(p, atoms);
+        p = read(p, chunks);
+
+        if ((chunks != (atoms + chunkAtoms - 1) / chunkAtoms) || (size < headerSize + chunks * sizeof(uint64_t)))
+            return false;
+
+        if ((key == 0) && (!m_started || (m_previous[0].size() != atoms)))
+            return false;
+
+        const uint8_t* end   = data + size;
+        const uint8_t* bytes = p + chunks * sizeof(uint64_t);
+
+        for (size_t k = 0; k < Dim; ++k)
+        {
+            m_previous[k].resize(atoms, 0);
+            m_step[k].resize(atoms, 0);
+            r[k].resize(atoms);
+        }
+
+        for (uint64_t chunk = 0; chunk < chunks; ++chunk)
+        {
+            uint64_t chunkSize = 0;
+
+            p = read(p, chunkSize);
+
+            if (chunkSize > uint64_t(end - bytes))
+            {
+                m_started = false;
+                return false;
+            }
+
+            size_t begin = chunk * chunkAtoms;
+            size_t last  = std::min<size_t>(begin + chunkAtoms, atoms);
+
+            if (!decode_chunk(bytes, bytes + chunkSize, begin, last, key != 0, quantum, r))
+            {
+                m_started = false;
+                return false;
+            }
+
+            bytes += chunkSize;
+        }
+
+        m_started = true;
+
+        return true;
+    };
+
+private:    // methods
+
+    //*****************************************************************************************************
+    // decode_chunk() - decode atoms of a chunk, all axes
+    //*****************************************************************************************************
+    //! @param [in] data first byte of chunk
+    //! @param [in] end byte after the chunk
+    //! @param [in] begin first atom
+    //! @param [in] last atom after the last one
+    //! @param [in] key frame is encoded against zero
+    //! @param [in] quantum step of quantized coordinates
+    //! @param [out] r coordinates
+    //! @return false for a broken chunk
+    //*****************************************************************************************************
+    bool decode_chunk(const uint8_t* data, const uint8_t* end, size_t begin, size_t last, bool key, double quantum,
+                      std::array<std::vector<double>, Dim>& r)
+    {
+        using namespace trajectory_codec;
+
+        for (size_t k = 0; k < Dim; ++k)
+        {
+            if (data >= end)
+                return false;
+
+            uint32_t param = *data++;
+
+            // parts of axes are padded to whole bytes, so the next part starts where this one ends
+            BitReader bits(data, end);
+            size_t    used = 0;
+
+            for (size_t i = begin; i < last; ++i)
+            {
+                uint64_t code  = read_rice(bits, param);
+                int64_t  delta = unzigzag(code);
+                int64_t  q     = key ? delta : m_previous[k][i] + m_step[k][i] + delta;
+
+                m_step[k][i]     = key ? 0 : q - m_previous[k][i];
+                m_previous[k][i] = q;
+                r[k][i]          = double(q) * quantum;
+
+                used += bits_of(code, param);
+            }
+
+            if (bits.IsOver())
+                return false;
+
+            data += (used + 7) / 8;
+        }
+
+        return true;
+    };
+
+    //*****************************************************************************************************
+    // bits_of() - get length of Rice code written by write_rice()
+    //*****************************************************************************************************
+    //! @param [in] value value
+    //! @param [in] k Rice parameter
+    //! @return number of bits
+    //*****************************************************************************************************
+    static size_t bits_of(uint64_t value, uint32_t k)
+    {
+        uint64_t unary = value >> k;
+
+        return (unary >= trajectory_codec::maxUnary) ? trajectory_codec::maxUnary + 64 : unary + 1 + k;
+    };
+
+    //*****************************************************************************************************
+    // read() - read value from bytes
+    //*****************************************************************************************************
+    //! @param [in] p first byte
+    //! @param [out] value value
+    //! @return byte after the value
+    //*****************************************************************************************************
+    template <typename T>
+    static const uint8_t* read(const uint8_t* p, T& value)
+    {
+        memcpy(&value, p, sizeof(T));
+
+        return p + sizeof(T);
+    };
+};
+
+//*********************************************************************************************************
+// Trajectory file
+//*********************************************************************************************************
+// Layout: magic "EVAPTRJ", version and dimension (uint32), then frames, each as its size in bytes
+// (uint64) followed by the frame of TrajectoryEncoder.
+//*********************************************************************************************************
+namespace trajectory_file
+{
+    constexpr static char     magic[8] = "EVAPTRJ";                                  //!< First bytes of file
+    constexpr static uint32_t version  = 1;                                          //!< Version of layout
+}
+
+//*********************************************************************************************************
+// TrajectoryWriter - record frames of a model into a compressed trajectory file
+//*********************************************************************************************************
+template <size_t Dim>
+class TrajectoryWriter
+{
+private:    // variables
+
+    std::ofstream                        m_file;                                     //!< Output file
+    TrajectoryEncoder<Dim>               m_encoder;                                  //!< Encoder of frames
+    std::vector<uint8_t>                 m_frame;                                    //!< Last encoded frame, kept between frames
+    std::array<std::vector<double>, Dim> m_r;                                        //!< Copy of published coordinates
+    uint64_t                             m_frames = 0;                               //!< Number of written frames
+    uint64_t                             m_bytes  = 0;                               //!< Number of written bytes of frames
+
+public:     // methods
+
+    //*****************************************************************************************************
+    // Constructor - create file and write header
+    //*****************************************************************************************************
+    //! @param [in] path path of file
+    //! @param [in] precision quantum in equilibrium distances
+    //! @param [in] distance equilibrium distance of the model
+    //! @param [in, optional] threads number of encoding threads, 0 means hardware concurrency
+    //! @param [in, optional] keyInterval frames between key frames
+    //*****************************************************************************************************
+    TrajectoryWriter(const std::string& path, double precision, double distance, size_t threads = 0,
+                     uint32_t keyInterval = 100)
+        : m_file(path, std::ios::binary | std::ios::trunc)
+        , m_encoder(precision, distance, threads, keyInterval)
+    {
+        uint32_t header[2] = { trajectory_file::version, uint32_t(Dim) };
+
+        m_file.write(trajectory_file::magic, sizeof(trajectory_file::magic));
+        m_file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    };
+
+    //*****************************************************************************************************
+    // IsOpen() - check that file was created and all writes succeeded
+    //*****************************************************************************************************
+    //! @return true if file is fine
+    //*****************************************************************************************************
+    bool IsOpen() const
+    {
+        return m_file.good();
+    };
+
+    //*****************************************************************************************************
+    // Write() - encode and write frame
+    //*****************************************************************************************************
+    //! @param [in] r coordinates, one span per axis of the same size
+    //! @param [in] iteration iteration of the frame
+    //*****************************************************************************************************
+    void Write(const std::array<Span<const double>, Dim>& r, uint32_t iteration)
+    {
+        m_encoder.Encode(r, iteration, m_frame);
+
+        uint64_t size = m_frame.size();
+
+        m_file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        m_file.write(reinterpret_cast<const char*>(m_frame.data()), m_frame.size());
+
+        ++m_frames;
+        m_bytes += sizeof(size) + size;
+    };
+
+    //*****************************************************************************************************
+    // Record() - write the last coordinates published by a model, see ObserveParticlePositions()
+    //*****************************************************************************************************
+    //! @param [in] model model with ObserveParticlePositions(), may be processed by another thread
+    //*****************************************************************************************************
+    template <typename System>
+    void Record(System& model)
+    {
+        uint32_t iteration = 0;
+
+        // the snapshot is copied first, a copy torn by the writer is taken again
+        while (true)
+        {
+            auto view = model.ObserveParticlePositions();
+
+            for (size_t k = 0; k < Dim; ++k)
+                m_r[k].assign(view[k].begin(), view[k].end());
+
+            iteration = view.GetIteration();
+
+            if (view.IsValid())
+                break;
+        }
+
+        std::array<Span<const double>, Dim> r;
+
+        for (size_t k = 0; k < Dim; ++k)
+            r[k] = Span<const double>(m_r[k].data(), m_r[k].size());
+
+        Write(r, iteration);
+    };
+
+    //*****************************************************************************************************
+    // GetFramesAmount() - get number of written frames
+    //*****************************************************************************************************
+    //! @return number of frames
+    //*****************************************************************************************************
+    uint64_t GetFramesAmount() const
+    {
+        return m_frames;
+    };
+
+    //*****************************************************************************************************
+    // GetBytes() - get size of written frames with their sizes
+    //*****************************************************************************************************
+    //! @return number of bytes
+    //*****************************************************************************************************
+    uint64_t GetBytes() const
+    {
+        return m_bytes;
+    };
+};
+
+//*********************************************************************************************************
+// TrajectoryReader - read frames of a file written by TrajectoryWriter one by one
+//*********************************************************************************************************
+template <size_t Dim>
+class TrajectoryReader
+{
+private:    // variables
+
+    std::ifstream          m_file;                                                   //!< Input file
+    TrajectoryDecoder<Dim> m_decoder;                                                //!< Decoder of frames
+    std::vector<uint8_t>   m_frame;                                                  //!< Last read frame
+    bool                   m_valid = false;                                          //!< Header was read and matches
+
+public:     // methods
+
+    //*****************************************************************************************************
+    // Constructor - open file and read header
+    //*****************************************************************************************************
+    //! @param [in] path path of file
+    //*****************************************************************************************************
+    explicit TrajectoryReader(const std::string& path)
+        : m_file(path, std::ios::binary)
+    {
+        char     magic[sizeof(trajectory_file::magic)] = {};
+        uint32_t header[2] = {};
+
+        m_file.read(magic, sizeof(magic));
+        m_file.read(reinterpret_cast<char*>(header), sizeof(header));
+
+        m_valid = m_file.good() && (memcmp(magic, trajectory_file::magic, sizeof(magic)) == 0) &&
+                  (header[0] == trajectory_file::version) && (header[1] == Dim);
+    };
+
+    //*****************************************************************************************************
+    // IsValid() - check that file is a trajectory of known version and dimension
+    //*****************************************************************************************************
+    //! @return true if frames can be read
+    //*****************************************************************************************************
+    bool IsValid() const
+    {
+        return m_valid;
+    };
+
+    //*****************************************************************************************************
+    // Next() - read and decode next frame
+    //*****************************************************************************************************
+    //! @param [out] r coordinates, one array per axis
+    //! @param [out] iteration iteration of the frame
+    //! @return false at the end of file, on a broken frame or on a size beyond the end of file
+    //*****************************************************************************************************
+    bool Next(std::array<std::vector<double>, Dim>& r, uint32_t& iteration)
+    {
+        uint64_t size = 0;
+
+        if (!m_valid || !m_file.read(reinterpret_cast<char*>(&size), sizeof(size)))
+            return false;
+
+        // a broken size would allocate the frame before the short read is noticed
+        std::streamoff position = m_file.tellg();
+
+        m_file.seekg(0, std::ios::end);
+
+        std::streamoff end = m_file.tellg();
+
+        m_file.seekg(position);
+
+        if ((position < 0) || (end < position) || (size > uint64_t(end - position)))
+            return false;
+
+        m_frame.resize(size);
+
+        if (!m_file.read(reinterpret_cast<char*>(m_frame.data()), size))
+            return false;
+
+        return m_decoder.Decode(m_frame.data(), m_frame.size(), r, iteration);
+    };
+};
+
+// instantiated by the core library, see the end of evaporation.h
+#ifdef EVAPORATION_CORE
+extern template class TrajectoryEncoder<2>;
+extern template class TrajectoryEncoder<3>;
+extern template class TrajectoryDecoder<2>;
+extern template class TrajectoryDecoder<3>;
+#endif
+
+#endif    // TRAJECTORY_CODEC_H
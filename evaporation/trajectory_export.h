@@ -0,0 +1,488 @@
+#ifndef TRAJECTORY_EXPORT_H
+#define TRAJECTORY_EXPORT_H
+
+#include "span.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//*********************************************************************************************************
+// TrajectoryFormat - format of exported trajectory
+//*********************************************************************************************************
+enum class TrajectoryFormat
+{
+    Xyz,                                                                             //!< Plain XYZ, argon atoms in angstroms
+    ExtendedXyz,                                                                     //!< Extended XYZ with lattice, step and time
+    Dcd                                                                              //!< Binary CHARMM/NAMD DCD with unit cell
+};
+
+//*********************************************************************************************************
+// TrajectoryExporter - stream frames of a model to a file readable by VMD, OVITO, ASE or MDAnalysis
+//*********************************************************************************************************
+// The integrating thread only copies coordinates into a frame from a pool, formatting and writing are
+// done by a thread of the exporter. At most m_maxQueued frames wait, then the integrating thread
+// waits too, so a disk slower than the model bounds memory instead of hiding the cost.
+// 2D models get zero z coordinates.
+//*********************************************************************************************************
+template <size_t Dim>
+class TrajectoryExporter
+{
+private:    // types
+
+    //*****************************************************************************************************
+    // Frame - copy of coordinates waiting to be written
+    //*****************************************************************************************************
+    struct Frame
+    {
+        std::array<std::vector<double>, Dim> m_r;                                    //!< Coordinates, one array per axis
+        uint32_t                             m_iteration = 0;                        //!< Iteration of the frame
+        double                               m_time      = 0;                        //!< Simulated time in s
+        double                               m_timestep  = 0;                        //!< Time step in s
+    };
+
+private:    // variables
+
+    constexpr static double m_angstrom = 1E-10;                                      //!< Meters in angstrom
+    constexpr static double m_akmaTime = 48.88821E-15;                               //!< Seconds in AKMA unit of time of DCD
+
+    TrajectoryFormat        m_format;                                                //!< Format of file
+    std::string             m_path;                                                  //!< Path of file
+    std::ofstream           m_file;                                                  //!< Output file
+    uint32_t                m_every;                                                 //!< Iterations between frames fed by Feed()
+    size_t                  m_maxQueued;                                             //!< Frames which may wait for writing
+    std::array<double, Dim> m_box = {};                                              //!< Size of modeling area in m, zeros if not known
+
+    std::mutex              m_mutex;                                                 //!< Mutex for queue
+    std::condition_variable m_ready;                                                 //!< Signals queued frame to writer
+    std::condition_variable m_free;                                                  //!< Signals written frame to producer
+    std::deque<Frame>       m_queue;                                                 //!< Frames waiting for writing
+    std::vector<Frame>      m_spare;                                                 //!< Written frames for reuse
+    bool                    m_stop = false;                                          //!< Writer should exit after the queue
+    std::atomic<bool>       m_failed{false};                                         //!< A write of the writer failed
+
+    uint32_t                m_next    = 0;                                           //!< Iteration of the next frame fed by Feed()
+    bool                    m_started = false;                                       //!< A frame was fed by Feed()
+    uint32_t                m_frames  = 0;                                           //!< Number of written frames, used by the writer only
+    std::vector<char>       m_text;                                                  //!< Formatted frame, used by the writer only
+    std::vector<float>      m_single;                                                //!< Coordinates of one axis for DCD, used by the writer only
+
+    std::thread             m_writer;                                                //!< Thread formatting and writing frames
+
+public:     // methods
+
+    //*****************************************************************************************************
+    // Constructor - create file and start writing thread
+    //*****************************************************************************************************
+    //! @param [in] path path of file
+    //! @param [in] format format of file
+    //! @param [in, optional] every iterations between frames fed by Feed()
+    //! @param [in, optional] maxQueued frames which may wait for writing
+    //*****************************************************************************************************
+    TrajectoryExporter(const std::string& path, TrajectoryFormat format, uint32_t every = 1, size_t maxQueued = 4)
+        : m_format(format)
+        , m_path(path)
+        , m_file(path, std::ios::binary | std::ios::trunc)
+        , m_every(std::max(1u, every))
+        , m_maxQueued(std::max<size_t>(1, maxQueued))
+        , m_failed(!m_file.good())
+        , m_writer([this] { writer(); })
+    {
+    };
+
+    TrajectoryExporter(const TrajectoryExporter&)            = delete;
+    TrajectoryExporter& operator=(const TrajectoryExporter&) = delete;
+
+    //*****************************************************************************************************
+    // Destructor - write queued frames and close file
+    //*****************************************************************************************************
+    ~TrajectoryExporter()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+
+        m_ready.notify_one();
+        m_writer.join();
+
+        if (m_format == TrajectoryFormat::Dcd)
+            finish_dcd();
+    };
+
+    //*****************************************************************************************************
+    // IsOpen() - check that file was created and all writes succeeded so far
+    //*****************************************************************************************************
+    //! @return true if file is fine
+    //*****************************************************************************************************
+    bool IsOpen() const
+    {
+        return !m_failed.load(std::memory_order_relaxed);
+    };
+
+    //*****************************************************************************************************
+    // SetBox() - set size of the modeling area for lattice of extended XYZ and unit cell of DCD
+    //*****************************************************************************************************
+    //! @param [in] box width, height (and depth) in m, see GetModelingSpace()
+    //*****************************************************************************************************
+    void SetBox(const std::array<double, Dim>& box)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_box = box;
+    };
+
+    //*****************************************************************************************************
+    // Feed() - record the model if at least `every` iterations passed since the last fed frame
+    //*****************************************************************************************************
+    //! @param [in] model model with ObserveParticlePositions() and GetIteration()
+    //! @return true if the frame was recorded
+    //*****************************************************************************************************
+    template <typename System>
+    bool Feed(System& model)
+    {
+        uint32_t iteration = model.GetIteration();
+
+        if (m_started && (iteration < m_next))
+            return false;
+
+        Record(model);
+
+        m_started = true;
+        m_next    = iteration + m_every;
+
+        return true;
+    };
+
+    //*****************************************************************************************************
+    // Record() - record the last coordinates published by a model
+    //*****************************************************************************************************
+    //! @param [in] model model with ObserveParticlePositions(), time is taken from its snapshot
+    //*****************************************************************************************************
+    template <typename System>
+    void Record(System& model)
+    {
+        Frame frame = take();
+
+        // a copy torn by the integrating thread is taken again
+        while (true)
+        {
+            auto view = model.ObserveParticlePositions();
+
+            for (size_t k = 0; k < Dim; ++k)
+                frame.m_r[k].assign(view[k].begin(), view[k].end());
+
+            frame.m_iteration = view.GetIteration();
+            frame.m_time      = view.GetSimulatedTime();
+            frame.m_timestep  = view.GetTimeStep();
+
+            if (view.IsValid())
+                break;
+        }
+
+        push(std::move(frame));
+    };
+
+    //*****************************************************************************************************
+    // Write() - record coordinates given by the caller
+    //*****************************************************************************************************
+    //! @param [in] r coordinates, one span per axis of the same size
+    //! @param [in] iteration iteration of the frame
+    //! @param [in, optional] time simulated time in s
+    //! @param [in, optional] timestep time step in s
+    //*****************************************************************************************************
+    void Write(const std::array<Span<const double>, Dim>& r, uint32_t iteration, double time = 0, double timestep = 0)
+    {
+        Frame frame = take();
+
+        for (size_t k = 0; k < Dim; ++k)
+            frame.m_r[k].assign(r[k].begin(), r[k].end());
+
+        frame.m_iteration = iteration;
+        frame.m_time      = time;
+        frame.m_timestep  = timestep;
+
+        push(std::move(frame));
+    };
+
+private:    // methods
+
+    //*****************************************************************************************************
+    // take() - take a frame from the pool, wait while too many frames are queued
+    //*****************************************************************************************************
+    //! @return frame, its buffers keep capacity of earlier frames
+    //*****************************************************************************************************
+    Frame take()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        m_free.wait(lock, [this] { return m_queue.size() < m_maxQueued; });
+
+        if (m_spare.empty())
+            return Frame();
+
+        Frame frame = std::move(m_spare.back());
+        m_spare.pop_back();
+
+        return frame;
+    };
+
+    //*****************************************************************************************************
+    // push() - queue frame for writing
+    //*****************************************************************************************************
+    //! @param [in] frame frame to write
+    //*****************************************************************************************************
+    void push(Frame&& frame)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_queue.push_back(std::move(frame));
+        }
+
+        m_ready.notify_one();
+    };
+
+    //*****************************************************************************************************
+    // writer() - format and write queued frames until the exporter is destroyed
+    //*****************************************************************************************************
+    void writer()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        while (true)
+        {
+            m_ready.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+
+            if (m_queue.empty())
+                return;
+
+            Frame                   frame = std::move(m_queue.front());
+            std::array<double, Dim> box   = m_box;
+
+            m_queue.pop_front();
+
+            // the producer may fill the next frame while this one is written
+            lock.unlock();
+            m_free.notify_one();
+
+            if (m_format == TrajectoryFormat::Dcd)
+                write_dcd(frame, box);
+            else
+                write_xyz(frame, box);
+
+            ++m_frames;
+
+            if (!m_file.good())
+                m_failed = true;
+
+            lock.lock();
+            m_spare.push_back(std::move(frame));
+        }
+    };
+
+    //*****************************************************************************************************
+    // write_xyz() - write frame as XYZ or extended XYZ
+    //*****************************************************************************************************
+    //! @param [in] frame frame to write
+    //! @param [in] box size of modeling area
+    //*****************************************************************************************************
+    void write_xyz(const Frame& frame, const std::array<double, Dim>& box)
+    {
+        size_t atoms = frame.m_r[0].size();
+        char   line[128];
+
+        m_text.clear();
+        append(line, snprintf(line, sizeof(line), "%zu\n", atoms));
+
+        if (m_format == TrajectoryFormat::ExtendedXyz)
+        {
+            double size[3] = { 0, 0, 0 };
+
+            for (size_t k = 0; k < Dim; ++k)
+                size[k] = box[k] / m_angstrom;
+
+            // third vector of a 2D area is a unit one, so the lattice is not singular
+            if (Dim == 2)
+                size[2] = 1;
+
+            if (box[0] > 0)
+                append(line, snprintf(line, sizeof(line), "Lattice=\"%.6f 0 0 0 %.6f 0 0 0 %.6f\" ",
+                                      size[0], size[1], size[2]));
+
+            append(line, snprintf(line, sizeof(line), "Properties=species:S:1:pos:R:3 Step=%u Time=%.6f\n",
+                                  frame.m_iteration, frame.m_time * 1E12));
+        }
+        else
+        {
+            append(line, snprintf(line, sizeof(line), "Step %u Time %.6f ps\n", frame.m_iteration, frame.m_time * 1E12));
+        }
+
+        // snprintf() per coordinate would cost more than the integration of a step
+        for (size_t i = 0; i < atoms; ++i)
+        {
+            m_text.insert(m_text.end(), { 'A', 'r' });
+
+            for (size_t k = 0; k < 3; ++k)
+            {
+                m_text.push_back(' ');
+                append_fixed((k < Dim) ? frame.m_r[k][i] / m_angstrom : 0);
+            }
+
+            m_text.push_back('\n');
+        }
+
+        m_file.write(m_text.data(), m_text.size());
+    };
+
+    //*****************************************************************************************************
+    // write_dcd() - write frame as DCD, the header is written with the first frame
+    //*****************************************************************************************************
+    //! @param [in] frame frame to write
+    //! @param [in] box size of modeling area
+    //*****************************************************************************************************
+    void write_dcd(const Frame& frame, const std::array<double, Dim>& box)
+    {
+        int32_t atoms = int32_t(frame.m_r[0].size());
+
+        m_text.clear();
+
+        if (m_frames == 0)
+        {
+            // control record: number of frames is patched when the file is closed
+            int32_t control[21] = {};
+            float   delta = float(frame.m_timestep / m_akmaTime);
+
+            memcpy(&control[0], "CORD", 4);
+            control[2]  = int32_t(frame.m_iteration);
+            control[3]  = int32_t(m_every);
+            memcpy(&control[10], &delta, sizeof(delta));
+            control[11] = 1;
+            control[20] = 24;
+            record(control, sizeof(control));
+
+            char title[84] = {};
+            int32_t titles = 1;
+
+            memcpy(title, &titles, sizeof(titles));
+            snprintf(title + 4, 80, "Evaporation of argon, Lennard-Jones model");
+            record(title, sizeof(title));
+
+            record(&atoms, sizeof(atoms));
+        }
+
+        // unit cell in CHARMM order a, gamma, b, beta, alpha, c with right angles
+        double cell[6] = { box[0] / m_angstrom, 90, box[1] / m_angstrom, 90, 90, (Dim > 2) ? box[Dim - 1] / m_angstrom : 0 };
+
+        record(cell, sizeof(cell));
+
+        m_single.resize(atoms);
+
+        for (size_t k = 0; k < 3; ++k)
+        {
+            for (int32_t i = 0; i < atoms; ++i)
+                m_single[i] = (k < Dim) ? float(frame.m_r[k][i] / m_angstrom) : 0.0f;
+
+            record(m_single.data(), m_single.size() * sizeof(float));
+        }
+
+        m_file.write(m_text.data(), m_text.size());
+    };
+
+    //*****************************************************************************************************
+    // finish_dcd() - write number of frames into the header of DCD
+    //*****************************************************************************************************
+    void finish_dcd()
+    {
+        m_file.close();
+
+        if (m_frames == 0)
+            return;
+
+        std::fstream file(m_path, std::ios::binary | std::ios::in | std::ios::out);
+        int32_t      frames = int32_t(m_frames);
+
+        // after the record marker and "CORD"
+        file.seekp(2 * sizeof(int32_t));
+        file.write(reinterpret_cast<const char*>(&frames), sizeof(frames));
+    };
+
+    //*****************************************************************************************************
+    // append() - append formatted line to the text of frame
+    //*****************************************************************************************************
+    //! @param [in] line formatted line
+    //! @param [in] size length of line
+    //*****************************************************************************************************
+    void append(const char* line, int size)
+    {
+        if (size > 0)
+            m_text.insert(m_text.end(), line, line + std::min<size_t>(size_t(size), 127));
+    };
+
+    //*****************************************************************************************************
+    // append_fixed() - append number with six decimals to the text of frame
+    //*****************************************************************************************************
+    //! @param [in] value number, huge and not finite numbers are written by printf
+    //*****************************************************************************************************
+    void append_fixed(double value)
+    {
+        if (!(fabs(value) < 1E12))
+        {
+            char line[32];
+
+            append(line, snprintf(line, sizeof(line), "%.6g", value));
+            return;
+        }
+
+        int64_t  scaled = llround(value * 1E6);
+        uint64_t digits = uint64_t((scaled < 0) ? -scaled : scaled);
+        char     text[32];
+        size_t   p = sizeof(text);
+
+        for (int d = 0; d < 6; ++d, digits /= 10)
+            text[--p] = char('0' + digits % 10);
+
+        text[--p] = '.';
+
+        do
+        {
+            text[--p] = char('0' + digits % 10);
+            digits /= 10;
+        }
+        while (digits != 0);
+
+        if (scaled < 0)
+            text[--p] = '-';
+
+        m_text.insert(m_text.end(), text + p, text + sizeof(text));
+    };
+
+    //*****************************************************************************************************
+    // record() - append Fortran unformatted record, data between two markers of its size
+    //*****************************************************************************************************
+    //! @param [in] data data of record
+    //! @param [in] size size of data in bytes
+    //*****************************************************************************************************
+    void record(const void* data, size_t size)
+    {
+        int32_t marker = int32_t(size);
+        auto    bytes  = reinterpret_cast<const char*>(data);
+        auto    mark   = reinterpret_cast<const char*>(&marker);
+
+        m_text.insert(m_text.end(), mark, mark + sizeof(marker));
+        m_text.insert(m_text.end(), bytes, bytes + size);
+        m_text.insert(m_text.end(), mark, mark + sizeof(marker));
+    };
+};
+
+#endif    // TRAJECTORY_EXPORT_H
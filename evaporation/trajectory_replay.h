@@ -0,0 +1,366 @@
+#ifndef TRAJECTORY_REPLAY_H
+#define TRAJECTORY_REPLAY_H
+
+#include "evaporation.h"
+#include "span.h"
+#include "trajectory_codec.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//*********************************************************************************************************
+// MappedFile - read-only memory mapping of a whole file
+//*********************************************************************************************************
+// Pages are read by the system on first access, so opening a long recording costs nothing until its
+// frames are touched. An empty or missing file gives an empty mapping.
+//*********************************************************************************************************
+class MappedFile
+{
+private:    // variables
+
+    const uint8_t* m_data = nullptr;                                                 //!< First byte of the mapping
+    size_t         m_size = 0;                                                       //!< Size of the file in bytes
+#ifdef _WIN32
+    HANDLE         m_file    = INVALID_HANDLE_VALUE;                                 //!< Handle of the file
+    HANDLE         m_mapping = nullptr;                                              //!< Handle of the mapping
+#endif
+
+public:     // methods
+
+    //*****************************************************************************************************
+    // Constructor - map file
+    //*****************************************************************************************************
+    //! @param [in] path path of file
+    //*****************************************************************************************************
+    explicit MappedFile(const std::string& path)
+    {
+#ifdef _WIN32
+        m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                             OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+        LARGE_INTEGER size = {};
+
+        if ((m_file == INVALID_HANDLE_VALUE) || !GetFileSizeEx(m_file, &size) || (size.QuadPart == 0))
+            return;
+
+        m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+        if (m_mapping == nullptr)
+            return;
+
+        m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+        m_size = (m_data != nullptr) ? size_t(size.QuadPart) : 0;
+#else
+        int file = open(path.c_str(), O_RDONLY);
+
+        if (file < 0)
+            return;
+
+        struct stat status = {};
+
+        if ((fstat(file, &status) == 0) && (status.st_size > 0))
+        {
+            void* data = mmap(nullptr, size_t(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+
+            if (data != MAP_FAILED)
+            {
+                m_data = static_cast<const uint8_t*>(data);
+                m_size = size_t(status.st_size);
+            }
+        }
+
+        // the mapping stays valid after the descriptor is closed
+        close(file);
+#endif
+    };
+
+    MappedFile(const MappedFile&)            = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    //*****************************************************************************************************
+    // Destructor - unmap file
+    //*****************************************************************************************************
+    ~MappedFile()
+    {
+#ifdef _WIN32
+        if (m_data != nullptr)
+            UnmapViewOfFile(m_data);
+        if (m_mapping != nullptr)
+            CloseHandle(m_mapping);
+        if (m_file != INVALID_HANDLE_VALUE)
+            CloseHandle(m_file);
+#else
+        if (m_data != nullptr)
+            munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+    };
+
+    //*****************************************************************************************************
+    // data() - get first byte of the file
+    //*****************************************************************************************************
+    //! @return pointer to mapped bytes, nullptr if the file was not mapped
+    //*****************************************************************************************************
+    const uint8_t* data() const
+    {
+        return m_data;
+    };
+
+    //*****************************************************************************************************
+    // size() - get size of the file
+    //*****************************************************************************************************
+    //! @return number of bytes, 0 if the file was not mapped
+    //*****************************************************************************************************
+    size_t size() const
+    {
+        return m_size;
+    };
+};
+
+//*********************************************************************************************************
+// TrajectoryReplay - random access to frames of a file written by TrajectoryWriter
+//*********************************************************************************************************
+// The file is mapped and indexed once: offsets of frames, their iterations and key frames. A frame is
+// decoded from the nearest key frame before it, or from the current frame when that is closer, so
+// playing forward costs one frame per step and scrubbing at most the interval between key frames.
+// A frame cut off at the end of a file which is still being written is left out of the index.
+//
+// Decoded coordinates are observed like the snapshots of a model: ObserveParticlePositions() gives a
+// view which another thread may read while Seek() is called, IsValid() of the view tells whether the
+// frame was replaced meanwhile. Buffers are reserved for the largest frame, so views never dangle.
+//*********************************************************************************************************
+template <size_t Dim>
+class TrajectoryReplay
+{
+public:     // types
+
+    using PositionsView = typename BasicModel<Dim>::PositionsView;                   //!< View of decoded coordinates
+
+private:    // types
+
+    //*****************************************************************************************************
+    // Entry - index entry of one frame
+    //*****************************************************************************************************
+    struct Entry
+    {
+        uint64_t m_offset;                                                           //!< Offset of the frame in the file
+        uint64_t m_size;                                                             //!< Size of the frame in bytes
+        uint32_t m_iteration;                                                        //!< Iteration of the frame
+        uint32_t m_key;                                                              //!< Index of the last key frame up to this one
+    };
+
+private:    // variables
+
+    MappedFile                             m_file;                                   //!< Mapped file
+    std::vector<Entry>                     m_index;                                  //!< Frames of the file
+    TrajectoryDecoder<Dim>                 m_decoder;                                //!< Decoder, its state is the current frame
+    std::array<std::vector<double>, Dim>   m_r;                                      //!< Coordinates of the current frame
+    uint32_t                               m_iteration = 0;                          //!< Iteration of the current frame
+    size_t                                 m_frame     = 0;                          //!< Index of the current frame
+    bool                                   m_decoded   = false;                      //!< Current frame holds decoded values
+    bool                                   m_valid     = false;                      //!< Header was read and matches
+    std::atomic<uint64_t>                  m_sequence{0};                            //!< Twice the number of decoded frames, odd while decoding
+    std::chrono::steady_clock::time_point  m_time;                                   //!< Time of decoding the current frame
+
+public:     // methods
+
+    //*****************************************************************************************************
+    // Constructor - map file and index its frames
+    //*****************************************************************************************************
+    //! @param [in] path path of file
+    //*****************************************************************************************************
+    explicit TrajectoryReplay(const std::string& path)
+        : m_file(path)
+    {
+        const size_t headerSize = sizeof(trajectory_file::magic) + 2 * sizeof(uint32_t);
+
+        const uint8_t* data = m_file.data();
+        size_t         size = m_file.size();
+
+        if (size < headerSize)
+            return;
+
+        uint32_t header[2] = {};
+
+        memcpy(header, data + sizeof(trajectory_file::magic), sizeof(header));
+
+        m_valid = (memcmp(data, trajectory_file::magic, sizeof(trajectory_file::magic)) == 0) &&
+                  (header[0] == trajectory_file::version) && (header[1] == Dim);
+
+        if (!m_valid)
+            return;
+
+        uint64_t offset = headerSize;
+        uint64_t atoms  = 0;
+        uint32_t key    = 0;
+
+        while (size - offset >= sizeof(uint64_t) + trajectory_codec::headerSize)
+        {
+            uint64_t frameSize  = 0;
+            uint32_t iteration  = 0;
+            uint32_t isKey      = 0;
+            uint64_t frameAtoms = 0;
+
+            memcpy(&frameSize, data + offset, sizeof(frameSize));
+            offset += sizeof(frameSize);
+
+            if (frameSize > size - offset)
+                break;
+
+            memcpy(&iteration, data + offset, sizeof(iteration));
+            memcpy(&isKey, data + offset + sizeof(iteration), sizeof(isKey));
+            memcpy(&frameAtoms, data + offset + 2 * sizeof(uint32_t) + sizeof(double), sizeof(frameAtoms));
+
+            if (isKey != 0)
+                key = uint32_t(m_index.size());
+
+            // a file has to start with a key frame
+            if (m_index.empty() && (isKey == 0))
+                break;
+
+            m_index.push_back({ offset, frameSize, iteration, key });
+
+            atoms   = std::max(atoms, frameAtoms);
+            offset += frameSize;
+        }
+
+        for (size_t k = 0; k < Dim; ++k)
+            m_r[k].reserve(atoms);
+
+        Seek(0);
+    };
+
+    TrajectoryReplay(const TrajectoryReplay&)            = delete;
+    TrajectoryReplay& operator=(const TrajectoryReplay&) = delete;
+
+    //*****************************************************************************************************
+    // IsValid() - check that file is a trajectory of known version and dimension
+    //*****************************************************************************************************
+    //! @return true if frames can be read
+    //*****************************************************************************************************
+    bool IsValid() const
+    {
+        return m_valid;
+    };
+
+    //*****************************************************************************************************
+    // GetFramesAmount() - get number of complete frames in the file
+    //*****************************************************************************************************
+    //! @return number of frames
+    //*****************************************************************************************************
+    size_t GetFramesAmount() const
+    {
+        return m_index.size();
+    };
+
+    //*****************************************************************************************************
+    // GetFrame() - get index of the current frame
+    //*****************************************************************************************************
+    //! @return index of frame
+    //*****************************************************************************************************
+    size_t GetFrame() const
+    {
+        return m_frame;
+    };
+
+    //*****************************************************************************************************
+    // GetIteration() - get iteration of a frame without decoding it
+    //*****************************************************************************************************
+    //! @param [in] frame index of frame
+    //! @return iteration of the frame, 0 for a frame out of the file
+    //*****************************************************************************************************
+    uint32_t GetIteration(size_t frame) const
+    {
+        return (frame < m_index.size()) ? m_index[frame].m_iteration : 0;
+    };
+
+    //*****************************************************************************************************
+    // Seek() - decode a frame and make it current
+    //*****************************************************************************************************
+    //! @param [in] frame index of frame, larger indices go to the last frame
+    //! @return false for an empty file or a broken frame
+    //*****************************************************************************************************
+    bool Seek(size_t frame)
+    {
+        if (m_index.empty())
+            return false;
+
+        frame = std::min(frame, m_index.size() - 1);
+
+        if (m_decoded && (frame == m_frame))
+            return true;
+
+        // delta frames need all frames since their key frame, the current one may be a closer start
+        size_t first = m_index[frame].m_key;
+
+        if (m_decoded && (m_frame < frame) && (m_frame >= first))
+            first = m_frame + 1;
+
+        uint64_t stamp = m_sequence.load(std::memory_order_relaxed) + 1;
+
+        m_sequence.store(stamp, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        m_decoded = true;
+
+        for (size_t i = first; (i <= frame) && m_decoded; ++i)
+        {
+            const Entry& e = m_index[i];
+
+            m_decoded = m_decoder.Decode(m_file.data() + e.m_offset, e.m_size, m_r, m_iteration);
+        }
+
+        m_frame = frame;
+        m_time  = std::chrono::steady_clock::now();
+
+        m_sequence.store(stamp + 1, std::memory_order_release);
+
+        return m_decoded;
+    };
+
+    //*****************************************************************************************************
+    // ObserveParticlePositions() - get view of the current frame without copying
+    //*****************************************************************************************************
+    //! @return view of coordinates, see BasicModel::ObserveParticlePositions()
+    //*****************************************************************************************************
+    PositionsView ObserveParticlePositions() const
+    {
+        while (true)
+        {
+            uint64_t stamp = m_sequence.load(std::memory_order_acquire);
+
+            // a frame is being decoded by another thread
+            if (stamp % 2 != 0)
+                continue;
+
+            std::array<Span<const double>, Dim> r;
+
+            for (size_t k = 0; k < Dim; ++k)
+                r[k] = Span<const double>(m_r[k].data(), m_decoded ? m_r[k].size() : 0);
+
+            PositionsView view(r, m_iteration, stamp, &m_sequence, m_time);
+
+            if (view.IsValid())
+                return view;
+        }
+    };
+};
+
+#endif    // TRAJECTORY_REPLAY_H
@@ -0,0 +1,8 @@
+# GUI with the core library it links, open this file to build both
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    core \
+    evaporation \
+
+evaporation.depends = core